@@ -152,7 +152,8 @@ int main() {
         GameState global_state(n, player_id, m, players, walls);
         GameState my_state = global_state.rotate_to_top();
 
-        if (tick <= 12) {
+        // The scripted opening is laid out for the 9x9 board
+        if (tick <= 12 && m == 9) {
             if (tick < 3)
                 my_state.step_command(4, 1);
             else if (tick < 5)
@@ -145,14 +145,17 @@ private:
 };
 
 pair<Pos, int> get_next_step(const GameState &my_state) {
-    vector<vector<Pos>> parent(my_state.m, vector<Pos>(my_state.m, {-1, -1}));
-    parent[my_state.my_pos.x][my_state.my_pos.y] = {-2, -2};
+    int m = my_state.m;
+    // Flat m * m grids indexed by y * m + x
+    vector<Pos> parent(m * m, {-1, -1});
+    parent[my_state.my_pos.y * m + my_state.my_pos.x] = {-2, -2};
     Pos start = my_state.my_pos;
     queue<pair<Pos, int>> queue;
     queue.push({my_state.my_pos, 0});
-    vector<vector<bool>> player_pos(my_state.m, vector<bool>(my_state.m, false));
+    vector<bool> player_pos(m * m, false);
     for (const Player &player: my_state.players) {
-        player_pos[player.x][player.y] = true;
+        if (player.x >= 0)
+            player_pos[player.y * m + player.x] = true;
     }
     while (!queue.empty()) {
         Pos pos = queue.front().first;
@@ -160,46 +163,46 @@ pair<Pos, int> get_next_step(const GameState &my_state) {
         queue.pop();
         if (pos.y == my_state.m - 1) {
             Pos step;
-            for (step = pos; parent[step.x][step.y].x != start.x || parent[step.x][step.y].y != start.y; step = parent[step.x][step.y]);
+            for (step = pos; parent[step.y * m + step.x].x != start.x || parent[step.y * m + step.x].y != start.y; step = parent[step.y * m + step.x]);
             return {step, dist};
         }
 
-        if (!my_state.borders[pos.x][pos.y].left && parent[pos.x - 1][pos.y].x == -1 && (dist > 0 || !player_pos[pos.x - 1][pos.y])) {
+        if (!my_state.borders[pos.x][pos.y].left && parent[pos.y * m + pos.x - 1].x == -1 && (dist > 0 || !player_pos[pos.y * m + pos.x - 1])) {
             queue.push({{pos.x - 1, pos.y}, dist + 1});
-            parent[pos.x - 1][pos.y] = pos;
+            parent[pos.y * m + pos.x - 1] = pos;
         }
-        if (!my_state.borders[pos.x][pos.y].right && parent[pos.x + 1][pos.y].x == -1 && (dist > 0 || !player_pos[pos.x + 1][pos.y])) {
+        if (!my_state.borders[pos.x][pos.y].right && parent[pos.y * m + pos.x + 1].x == -1 && (dist > 0 || !player_pos[pos.y * m + pos.x + 1])) {
             queue.push({{pos.x + 1, pos.y}, dist + 1});
-            parent[pos.x + 1][pos.y] = pos;
+            parent[pos.y * m + pos.x + 1] = pos;
         }
-        if (!my_state.borders[pos.x][pos.y].top && parent[pos.x][pos.y - 1].x == -1 && (dist > 0 || !player_pos[pos.x][pos.y - 1])) {
+        if (!my_state.borders[pos.x][pos.y].top && parent[(pos.y - 1) * m + pos.x].x == -1 && (dist > 0 || !player_pos[(pos.y - 1) * m + pos.x])) {
             queue.push({{pos.x, pos.y - 1}, dist + 1});
-            parent[pos.x][pos.y - 1] = pos;
+            parent[(pos.y - 1) * m + pos.x] = pos;
         }
-        if (!my_state.borders[pos.x][pos.y].bottom && parent[pos.x][pos.y + 1].x == -1 && (dist > 0 || !player_pos[pos.x][pos.y + 1])) {
+        if (!my_state.borders[pos.x][pos.y].bottom && parent[(pos.y + 1) * m + pos.x].x == -1 && (dist > 0 || !player_pos[(pos.y + 1) * m + pos.x])) {
             queue.push({{pos.x, pos.y + 1}, dist + 1});
-            parent[pos.x][pos.y + 1] = pos;
+            parent[(pos.y + 1) * m + pos.x] = pos;
         }
         if (dist == 0) {
-            if (!my_state.borders[pos.x][pos.y].left && player_pos[pos.x - 1][pos.y] && !my_state.borders[pos.x - 1][pos.y].left &&
-                parent[pos.x - 2][pos.y].x == -1) {
+            if (!my_state.borders[pos.x][pos.y].left && player_pos[pos.y * m + pos.x - 1] && !my_state.borders[pos.x - 1][pos.y].left &&
+                parent[pos.y * m + pos.x - 2].x == -1) {
                 queue.push({{pos.x - 2, pos.y}, dist + 1});
-                parent[pos.x - 2][pos.y] = pos;
+                parent[pos.y * m + pos.x - 2] = pos;
             }
-            if (!my_state.borders[pos.x][pos.y].right && player_pos[pos.x + 1][pos.y] && !my_state.borders[pos.x + 1][pos.y].right &&
-                parent[pos.x + 2][pos.y].x == -1) {
+            if (!my_state.borders[pos.x][pos.y].right && player_pos[pos.y * m + pos.x + 1] && !my_state.borders[pos.x + 1][pos.y].right &&
+                parent[pos.y * m + pos.x + 2].x == -1) {
                 queue.push({{pos.x + 2, pos.y}, dist + 1});
-                parent[pos.x + 2][pos.y] = pos;
+                parent[pos.y * m + pos.x + 2] = pos;
             }
-            if (!my_state.borders[pos.x][pos.y].top && player_pos[pos.x][pos.y - 1] && !my_state.borders[pos.x][pos.y - 1].top &&
-                parent[pos.x][pos.y - 2].x == -1) {
+            if (!my_state.borders[pos.x][pos.y].top && player_pos[(pos.y - 1) * m + pos.x] && !my_state.borders[pos.x][pos.y - 1].top &&
+                parent[(pos.y - 2) * m + pos.x].x == -1) {
                 queue.push({{pos.x, pos.y - 2}, dist + 1});
-                parent[pos.x][pos.y - 2] = pos;
+                parent[(pos.y - 2) * m + pos.x] = pos;
             }
-            if (!my_state.borders[pos.x][pos.y].bottom && player_pos[pos.x][pos.y + 1] && !my_state.borders[pos.x][pos.y + 1].bottom &&
-                parent[pos.x][pos.y + 2].x == -1) {
+            if (!my_state.borders[pos.x][pos.y].bottom && player_pos[(pos.y + 1) * m + pos.x] && !my_state.borders[pos.x][pos.y + 1].bottom &&
+                parent[(pos.y + 2) * m + pos.x].x == -1) {
                 queue.push({{pos.x, pos.y + 2}, dist + 1});
-                parent[pos.x][pos.y + 2] = pos;
+                parent[(pos.y + 2) * m + pos.x] = pos;
             }
             // TODO implement turn-jumps
         }
@@ -232,7 +235,7 @@ int main() {
         Pos step_pos = step.first;
         int step_dist = step.second;
 
-        if (step_pos.y == 8) {
+        if (step_pos.y == m - 1) {
             // just take the winning step
             my_state.step_command(step_pos.x, step_pos.y);
             continue;
@@ -0,0 +1,438 @@
+#pragma once
+
+/**
+ * Multiword bitboards for boards up to 31x31, for bots built on quoridor_bot.cpp. Include it after the
+ * template's GameState.
+ *
+ *     BoardGraph graph(my_state);
+ *     int my_distance = graph.distance(my_state.my_pos, goal_side(my_state, my_state.player_id));
+ *     BoardGraph::WallSlots cuts = graph.cutting_walls(pawn, side);
+ *     if (!cuts[graph.wall_slot(wall)]) { ... }
+ *
+ * Bit y * m + x of a Bitboard stands for the cell (x, y). The graph keeps one Bitboard per direction with
+ * the cells a pawn can leave that way, so a whole BFS layer is expanded with four masked shifts instead of
+ * visiting the cells one by one. Which walls would cut a pawn off is answered for all wall slots at once
+ * from the bridges and 2-edge cuts between the pawn and its goal. This is the same layout and algorithm as
+ * src/board.ts on the server.
+ */
+
+#include <bits/stdc++.h>
+
+using namespace std;
+
+/** A set of cells */
+struct Bitboard {
+    static constexpr int WORDS = 16;
+
+    array<uint64_t, WORDS> words{};
+
+    void set(int cell) { words[cell >> 6] |= 1ULL << (cell & 63); }
+
+    void reset(int cell) { words[cell >> 6] &= ~(1ULL << (cell & 63)); }
+
+    bool test(int cell) const { return cell >= 0 && words[cell >> 6] >> (cell & 63) & 1; }
+
+    bool any() const {
+        uint64_t any = 0;
+        for (uint64_t word: words)
+            any |= word;
+        return any != 0;
+    }
+
+    int count() const {
+        int count = 0;
+        for (uint64_t word: words)
+            count += __builtin_popcountll(word);
+        return count;
+    }
+
+    /** Index of the lowest cell in the set, -1 if it is empty */
+    int first() const {
+        for (int i = 0; i < WORDS; ++i) {
+            if (words[i])
+                return i * 64 + __builtin_ctzll(words[i]);
+        }
+        return -1;
+    }
+
+    Bitboard operator&(const Bitboard &other) const {
+        Bitboard result;
+        for (int i = 0; i < WORDS; ++i)
+            result.words[i] = words[i] & other.words[i];
+        return result;
+    }
+
+    Bitboard operator|(const Bitboard &other) const {
+        Bitboard result;
+        for (int i = 0; i < WORDS; ++i)
+            result.words[i] = words[i] | other.words[i];
+        return result;
+    }
+
+    Bitboard &operator|=(const Bitboard &other) {
+        for (int i = 0; i < WORDS; ++i)
+            words[i] |= other.words[i];
+        return *this;
+    }
+
+    /** The cells of this set that are not in `other` */
+    Bitboard without(const Bitboard &other) const {
+        Bitboard result;
+        for (int i = 0; i < WORDS; ++i)
+            result.words[i] = words[i] & ~other.words[i];
+        return result;
+    }
+
+    /** Moves every cell index by `offset`, which has to be between -63 and 63 */
+    Bitboard shifted(int offset) const {
+        Bitboard result;
+        if (offset > 0) {
+            for (int i = WORDS - 1; i >= 0; --i)
+                result.words[i] = words[i] << offset | (i > 0 ? words[i - 1] >> (64 - offset) : 0);
+        } else if (offset < 0) {
+            offset = -offset;
+            for (int i = 0; i < WORDS; ++i)
+                result.words[i] = words[i] >> offset | (i < WORDS - 1 ? words[i + 1] << (64 - offset) : 0);
+        } else {
+            result = *this;
+        }
+        return result;
+    }
+};
+
+enum Side { TOP, RIGHT, BOTTOM, LEFT };
+
+/**
+ * The side of the board `player` has to reach, in the frame of `state`, which has to be a `rotate_to_top`
+ * state: the template's player always goes for the bottom.
+ */
+template<typename State>
+Side goal_side(const State &state, int player) {
+    // Rotating the board counter clockwise by a quarter turn takes every side to the previous one
+    int quarters = (state.n == 2 ? 2 : 1) * (state.player_id - player);
+    return Side(((BOTTOM - quarters) % 4 + 4) % 4);
+}
+
+/** Pawn connectivity of the board, pawns ignored */
+class BoardGraph {
+public:
+    static constexpr int MAX_SIZE = 31;
+    static constexpr int MAX_SLOTS = 2 * (MAX_SIZE - 1) * (MAX_SIZE - 1);
+
+    using WallSlots = bitset<MAX_SLOTS>;
+
+    template<typename State>
+    explicit BoardGraph(const State &state) : m(state.m) {
+        if (m > MAX_SIZE)
+            throw invalid_argument("board is too large for BoardGraph");
+        for (int y = 0; y < m; ++y) {
+            for (int x = 0; x < m; ++x) {
+                const auto &borders = state.borders[x][y];
+                int cell = y * m + x;
+                if (!borders.top)
+                    can[TOP].set(cell);
+                if (!borders.right)
+                    can[RIGHT].set(cell);
+                if (!borders.bottom)
+                    can[BOTTOM].set(cell);
+                if (!borders.left)
+                    can[LEFT].set(cell);
+            }
+        }
+        for (int i = 0; i < m; ++i) {
+            goals[TOP].set(i);
+            goals[RIGHT].set(i * m + m - 1);
+            goals[BOTTOM].set((m - 1) * m + i);
+            goals[LEFT].set(i * m);
+        }
+    }
+
+    int size() const { return m; }
+
+    const Bitboard &goal(Side side) const { return goals[side]; }
+
+    bool can_step(Pos from, Side direction) const { return can[direction].test(from.y * m + from.x); }
+
+    void place_wall(const Wall &wall) { set_wall(wall, true); }
+
+    void remove_wall(const Wall &wall) { set_wall(wall, false); }
+
+    /** The cells one step away from some cell of `cells` */
+    Bitboard neighbors(const Bitboard &cells) const {
+        return (cells & can[TOP]).shifted(-m) | (cells & can[RIGHT]).shifted(1) | (cells & can[BOTTOM]).shifted(m) |
+               (cells & can[LEFT]).shifted(-1);
+    }
+
+    /** The connected area of the cell */
+    Bitboard reachable(Pos from) const {
+        Bitboard visited, frontier;
+        frontier.set(from.y * m + from.x);
+        visited = frontier;
+        while (frontier.any()) {
+            frontier = neighbors(frontier).without(visited);
+            visited |= frontier;
+        }
+        return visited;
+    }
+
+    /** Length of the shortest path from `from` to the side, -1 if there is none */
+    int distance(Pos from, Side side) const {
+        return distance(from, goals[side]);
+    }
+
+    int distance(Pos from, const Bitboard &goal) const {
+        Bitboard visited, frontier;
+        frontier.set(from.y * m + from.x);
+        visited = frontier;
+        for (int depth = 0; frontier.any(); ++depth) {
+            if ((frontier & goal).any())
+                return depth;
+            frontier = neighbors(frontier).without(visited);
+            visited |= frontier;
+        }
+        return -1;
+    }
+
+    int wall_slot(const Wall &wall) const { return (wall.y * (m - 1) + wall.x) * 2 + wall.is_vertical; }
+
+    /** Whether placing the wall would leave a pawn on `from` without a path to the side */
+    bool wall_cuts_off(Pos from, Side side, const Wall &wall) { return cached_table(from, side).cuts[wall_slot(wall)]; }
+
+    /**
+     * The wall slots (`wall_slot`) that would cut a pawn on `from` off the side, for all of them at once.
+     * Slots that overlap the walls on the board are meaningless. A wall takes two edges out of the board,
+     * so it cuts the pawn off if one of them is a bridge between the pawn and the side, or if the two
+     * edges together are a cut. When there are 3 edge-disjoint paths to the side no wall can do that, and
+     * the table stays valid until a wall is placed on one of those paths.
+     *
+     * Returned by value: the cached table may be evicted by the next call or by `place_wall`.
+     */
+    WallSlots cutting_walls(Pos from, Side side) { return cached_table(from, side).cuts; }
+
+private:
+    struct CutTable {
+        /** Flow of 3 edge-disjoint paths to the goal by edge, empty if there are no 3 such paths */
+        vector<int8_t> flow;
+        WallSlots cuts;
+    };
+
+    /** The cached table of a pawn on `from`, only valid until the next call or the next wall change */
+    const CutTable &cached_table(Pos from, Side side) {
+        int key = (from.y * m + from.x) * 4 + side;
+        auto cached = tables.find(key);
+        if (cached == tables.end()) {
+            // Tables of pawns that moved on are never used again
+            if (tables.size() >= MAX_CACHED_TABLES)
+                tables.clear();
+            cached = tables.emplace(key, cut_table(from.y * m + from.x, goals[side])).first;
+        }
+        return cached->second;
+    }
+
+    static constexpr size_t MAX_CACHED_TABLES = 64;
+
+    int m;
+    /** The cells a pawn can leave in each direction */
+    array<Bitboard, 4> can;
+    array<Bitboard, 4> goals;
+    unordered_map<int, CutTable> tables;
+    /** Scratch space of `augment`, by cell */
+    vector<int> queue, parent_edge, parent_offset, seen;
+    int seen_runs = 0;
+    /** Scratch space of `find_bridges`, by node */
+    vector<int> discovered, low, stack_node, stack_edge, stack_next;
+    vector<bool> reaches_goal;
+    /** By edge, the last `find_bridges` run that found it to be a bridge */
+    vector<int> bridge_mark;
+    int bridge_runs = 0;
+
+    array<pair<Side, int>, 4> steps() const { return {{{RIGHT, 1}, {LEFT, -1}, {BOTTOM, m}, {TOP, -m}}}; }
+
+    void set_wall(const Wall &wall, bool blocked) {
+        int cell = wall.y * m + wall.x;
+        auto update = [blocked](Bitboard &bits, int cell) { blocked ? bits.reset(cell) : bits.set(cell); };
+        if (wall.is_vertical) {
+            update(can[RIGHT], cell);
+            update(can[RIGHT], cell + m);
+            update(can[LEFT], cell + 1);
+            update(can[LEFT], cell + m + 1);
+        } else {
+            update(can[BOTTOM], cell);
+            update(can[BOTTOM], cell + 1);
+            update(can[TOP], cell + m);
+            update(can[TOP], cell + m + 1);
+        }
+        // A placed wall only breaks the flow tables it crosses, a removed one only the tables with cuts
+        auto [first, second] = wall_edges(wall);
+        for (auto table = tables.begin(); table != tables.end();) {
+            const vector<int8_t> &flow = table->second.flow;
+            bool valid = !flow.empty() && (!blocked || (flow[first] == 0 && flow[second] == 0));
+            table = valid ? next(table) : tables.erase(table);
+        }
+    }
+
+    /**
+     * Edge ids: 2 * cell for the step right of the cell, 2 * cell + 1 for the step down. The links of the
+     * goal cells to the goal node of `find_bridges` come after them.
+     */
+    int edge_id(int cell, int offset) const {
+        int from = offset > 0 ? cell : cell + offset;
+        return 2 * from + (abs(offset) == 1 ? 0 : 1);
+    }
+
+    pair<int, int> wall_edges(const Wall &wall) const {
+        int cell = wall.y * m + wall.x;
+        return wall.is_vertical ? make_pair(2 * cell, 2 * (cell + m)) : make_pair(2 * cell + 1, 2 * (cell + 1) + 1);
+    }
+
+    CutTable cut_table(int source, const Bitboard &goal) {
+        CutTable table{vector<int8_t>(2 * m * m), {}};
+        if (goal.test(source))
+            return table;
+        vector<int> path;
+        int paths = 0;
+        while (paths < 3 && augment(source, goal, table.flow, paths == 0 ? &path : nullptr))
+            ++paths;
+        if (paths == 3)
+            return table;
+        table.flow.clear();
+        if (paths == 0) {
+            table.cuts.set();
+            return table;
+        }
+
+        // A wall that leaves the path alone cannot cut the pawn off, so only the edges of the path are
+        // taken out one by one, looking for the bridges that are left
+        vector<int> goal_cells;
+        for (int cell = 0; cell < m * m; ++cell) {
+            if (goal.test(cell))
+                goal_cells.push_back(cell);
+        }
+        int run = find_bridges(source, goal, goal_cells, -1);
+        vector<bool> is_bridge(path.size());
+        for (size_t i = 0; i < path.size(); ++i)
+            is_bridge[i] = bridge_mark[path[i]] == run;
+        for (size_t i = 0; i < path.size(); ++i) {
+            int edge = path[i], cell = edge >> 1, x = cell % m, y = cell / m;
+            Wall walls[2] = {{x, y, true}, {x, y - 1, true}};
+            if (edge & 1)
+                walls[0] = {x, y, false}, walls[1] = {x - 1, y, false};
+            int edge_run = is_bridge[i] ? 0 : find_bridges(source, goal, goal_cells, edge);
+            for (const Wall &wall: walls) {
+                if (wall.x < 0 || wall.y < 0 || wall.x >= m - 1 || wall.y >= m - 1)
+                    continue;
+                auto [first, second] = wall_edges(wall);
+                int partner = first == edge ? second : first;
+                if (is_bridge[i] || edge_run < 0 || bridge_mark[partner] == edge_run)
+                    table.cuts.set(wall_slot(wall));
+            }
+        }
+        return table;
+    }
+
+    /**
+     * Pushes one more unit of flow from the source to the goal along a shortest augmenting path, the edges
+     * being undirected with capacity 1. Appends the edges of that path to `path` if it is given. Returns
+     * false if the flow is already maximal.
+     */
+    bool augment(int source, const Bitboard &goal, vector<int8_t> &flow, vector<int> *path) {
+        queue.resize(m * m);
+        parent_edge.resize(m * m);
+        parent_offset.resize(m * m);
+        seen.resize(m * m);
+        int stamp = ++seen_runs;
+        queue[0] = source;
+        seen[source] = stamp;
+        for (int i = 0, end = 1; i < end; ++i) {
+            int cell = queue[i];
+            if (goal.test(cell)) {
+                for (int c = cell; c != source; c -= parent_offset[c]) {
+                    flow[parent_edge[c]] += parent_offset[c] > 0 ? 1 : -1;
+                    if (path)
+                        path->push_back(parent_edge[c]);
+                }
+                return true;
+            }
+            for (auto [direction, offset]: steps()) {
+                int next = cell + offset;
+                if (!can[direction].test(cell) || seen[next] == stamp)
+                    continue;
+                // Flow is counted positive from the lower cell to the higher one
+                int edge = edge_id(cell, offset);
+                if (flow[edge] == (offset > 0 ? 1 : -1))
+                    continue;
+                seen[next] = stamp;
+                parent_edge[next] = edge;
+                parent_offset[next] = offset;
+                queue[end++] = next;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Tarjan's bridge search from the source on the board without the `removed` edge, with one extra node
+     * linked to every goal cell. Marks the bridges that separate the source from the goal with the returned
+     * run number in `bridge_mark`. Returns -1 if the source cannot reach the goal at all.
+     */
+    int find_bridges(int source, const Bitboard &goal, const vector<int> &goal_cells, int removed) {
+        int run = ++bridge_runs, goal_node = m * m;
+        discovered.assign(goal_node + 1, -1);
+        low.resize(goal_node + 1);
+        reaches_goal.assign(goal_node + 1, false);
+        stack_node.resize(goal_node + 1);
+        stack_edge.resize(goal_node + 1);
+        stack_next.resize(goal_node + 1);
+        bridge_mark.resize(3 * goal_node);
+        auto step = steps();
+        int time = 0;
+        discovered[source] = low[source] = time++;
+        stack_node[0] = source;
+        stack_edge[0] = -1;
+        stack_next[0] = 0;
+        for (int top = 1; top > 0;) {
+            int node = stack_node[top - 1], i = stack_next[top - 1]++, next = -1, edge = -1;
+            if (node == goal_node) {
+                if (i < int(goal_cells.size()))
+                    next = goal_cells[i], edge = 2 * goal_node + next;
+            } else if (i < 4) {
+                auto [direction, offset] = step[i];
+                if (!can[direction].test(node) || (edge = edge_id(node, offset)) == removed)
+                    continue;
+                next = node + offset;
+            } else if (i == 4) {
+                if (!goal.test(node))
+                    continue;
+                next = goal_node, edge = 2 * goal_node + node;
+            }
+
+            if (next >= 0) {
+                if (edge == stack_edge[top - 1])
+                    continue;
+                if (discovered[next] >= 0) {
+                    low[node] = min(low[node], discovered[next]);
+                } else {
+                    discovered[next] = low[next] = time++;
+                    reaches_goal[next] = next == goal_node;
+                    stack_node[top] = next;
+                    stack_edge[top] = edge;
+                    stack_next[top] = 0;
+                    ++top;
+                }
+                continue;
+            }
+
+            // All the neighbors are done, back to the parent
+            if (--top == 0)
+                break;
+            int parent = stack_node[top - 1];
+            low[parent] = min(low[parent], low[node]);
+            if (reaches_goal[node]) {
+                reaches_goal[parent] = true;
+                if (low[node] > discovered[parent])
+                    bridge_mark[stack_edge[top]] = run;
+            }
+        }
+        return discovered[goal_node] >= 0 ? run : -1;
+    }
+};
@@ -0,0 +1,201 @@
+#pragma once
+
+/**
+ * Opening book lookup for bots built on quoridor_bot.cpp. Include it after the template's Player and Wall.
+ *
+ *     OpeningBook book("openings.book");
+ *     if (auto move = book.probe(my_state)) { ... }
+ *
+ * The book file is written by tools/book_builder.cpp: a header and an array of entries sorted by position
+ * key. It is memory-mapped and searched in place, so opening it costs no parsing at all. Positions are
+ * keyed from the point of view of the player to move (the `rotate_to_top` frame), and book moves are stored
+ * and returned in that frame. In two player games the left-right mirror image is folded onto the same key.
+ */
+
+#include <bits/stdc++.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/** Random but fixed 64 bit keys of the position features, XOR-ed together to get the position key */
+inline uint64_t zobrist_key(uint64_t feature) {
+    uint64_t z = feature + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/** `slot` is the player's turn order counted from the player to move. Pawns out of the game are at x = -1. */
+inline uint64_t zobrist_pawn(int slot, int x, int y) {
+    if (x < 0)
+        return zobrist_key(6ULL << 40 | uint64_t(slot));
+    return zobrist_key(1ULL << 40 | uint64_t(slot) << 16 | uint64_t(x) << 8 | uint64_t(y));
+}
+
+inline uint64_t zobrist_walls_left(int slot, int walls) {
+    return zobrist_key(2ULL << 40 | uint64_t(slot) << 16 | uint64_t(walls));
+}
+
+inline uint64_t zobrist_wall(int x, int y, bool is_vertical) {
+    return zobrist_key(3ULL << 40 | uint64_t(is_vertical) << 16 | uint64_t(x) << 8 | uint64_t(y));
+}
+
+inline uint64_t zobrist_board(int m, int n) {
+    return zobrist_key(4ULL << 40 | uint64_t(n) << 8 | uint64_t(m));
+}
+
+/** A pawn step or a wall placement, packed into 16 bits for the book file */
+struct BookMove {
+    bool is_wall;
+    int x, y;
+    bool is_vertical;
+
+    uint16_t encode() const {
+        return uint16_t(is_wall << 11 | is_vertical << 10 | x << 5 | y);
+    }
+
+    static BookMove decode(uint16_t code) {
+        return {bool(code >> 11 & 1), code >> 5 & 31, code & 31, bool(code >> 10 & 1)};
+    }
+
+    /** The same move on the board mirrored left to right */
+    BookMove mirror(int m) const {
+        if (is_wall)
+            return {true, m - 2 - x, y, is_vertical};
+        return {false, m - 1 - x, y, false};
+    }
+};
+
+/** Position key of a position seen from the player to move, and whether it was taken from the mirror image */
+struct BookKey {
+    uint64_t key;
+    bool mirrored;
+};
+
+/**
+ * `players` and `walls` must already be in the frame of the player to move (`mover`), like in the
+ * template's `rotate_to_top` state. With four players the mirror image is not the same position: the
+ * players to the mover's left and right would swap goals, so only two player positions are folded.
+ */
+inline BookKey book_key(int m, int n, int mover, const vector<Player> &players, const vector<Wall> &walls) {
+    uint64_t key = zobrist_board(m, n), mirrored = key;
+    for (int i = 0; i < n; ++i) {
+        int slot = (i - mover + n) % n;
+        const Player &player = players[i];
+        key ^= zobrist_pawn(slot, player.x, player.y) ^ zobrist_walls_left(slot, player.walls);
+        mirrored ^= zobrist_pawn(slot, player.x < 0 ? player.x : m - 1 - player.x, player.y) ^
+                    zobrist_walls_left(slot, player.walls);
+    }
+    for (const Wall &wall: walls) {
+        key ^= zobrist_wall(wall.x, wall.y, wall.is_vertical);
+        mirrored ^= zobrist_wall(m - 2 - wall.x, wall.y, wall.is_vertical);
+    }
+    return n == 2 && mirrored < key ? BookKey{mirrored, true} : BookKey{key, false};
+}
+
+const char BOOK_MAGIC[8] = {'Q', 'B', 'O', 'O', 'K', 0, 0, 3};
+
+/** Scores are counted in twelfths: a point shared by any number of players up to 4 stays exact */
+const int BOOK_SCORE_UNIT = 12;
+
+struct BookHeader {
+    char magic[8];
+    /** 0 if the book mixes board sizes or player counts, the key tells them apart anyway */
+    uint32_t board_size;
+    uint32_t num_players;
+    uint64_t num_entries;
+};
+
+/** One move of one position, the entries of a position are adjacent */
+struct BookEntry {
+    uint64_t key;
+    uint16_t move;
+    /** Number of games the move was played in, saturated at 65535 */
+    uint16_t games;
+    /** Score of the player to move summed over those games, in `BOOK_SCORE_UNIT`ths of a point */
+    uint32_t points;
+
+    double score() const { return points / (double(BOOK_SCORE_UNIT) * games); }
+};
+
+static_assert(sizeof(BookEntry) == 16, "BookEntry is read from disk as is");
+
+class OpeningBook {
+public:
+    /** An unreadable or missing file gives an empty book, bots should keep playing without it */
+    explicit OpeningBook(const string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(BookHeader)) {
+            void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data = static_cast<const char *>(mapped);
+                length = st.st_size;
+            }
+        }
+        close(fd);
+        const BookHeader *header = reinterpret_cast<const BookHeader *>(data);
+        if (!data || memcmp(header->magic, BOOK_MAGIC, sizeof(BOOK_MAGIC)) != 0 ||
+            sizeof(BookHeader) + header->num_entries * sizeof(BookEntry) > length) {
+            return;
+        }
+        board_size = header->board_size;
+        num_players = header->num_players;
+        entries = reinterpret_cast<const BookEntry *>(data + sizeof(BookHeader));
+        num_entries = header->num_entries;
+    }
+
+    OpeningBook(const OpeningBook &) = delete;
+
+    OpeningBook &operator=(const OpeningBook &) = delete;
+
+    ~OpeningBook() {
+        if (data)
+            munmap(const_cast<char *>(data), length);
+    }
+
+    bool empty() const { return num_entries == 0; }
+
+    /** All moves stored for a position key */
+    pair<const BookEntry *, const BookEntry *> find(uint64_t key) const {
+        const BookEntry *first = lower_bound(entries, entries + num_entries, key,
+                                             [](const BookEntry &entry, uint64_t key) { return entry.key < key; });
+        const BookEntry *last = first;
+        while (last != entries + num_entries && last->key == key)
+            ++last;
+        return {first, last};
+    }
+
+    /**
+     * The best scoring move played at least `min_games` times in this position, in the frame of `state`
+     * (which has to be a `rotate_to_top` state), so it can be passed to `step_command` or `wall_command`.
+     */
+    template<typename State>
+    optional<BookMove> probe(const State &state, int min_games = 2) const {
+        if (empty() || (board_size && state.m != board_size) || (num_players && state.n != num_players))
+            return nullopt;
+        BookKey key = book_key(state.m, state.n, state.player_id, state.players, state.walls);
+        auto [first, last] = find(key.key);
+        const BookEntry *best = nullptr;
+        for (const BookEntry *entry = first; entry != last; ++entry) {
+            if (entry->games >= min_games && (!best || entry->score() > best->score()))
+                best = entry;
+        }
+        if (!best)
+            return nullopt;
+        BookMove move = BookMove::decode(best->move);
+        return key.mirrored ? move.mirror(state.m) : move;
+    }
+
+private:
+    const char *data = nullptr;
+    size_t length = 0;
+    int board_size = 0, num_players = 0;
+    const BookEntry *entries = nullptr;
+    size_t num_entries = 0;
+};
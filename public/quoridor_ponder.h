@@ -0,0 +1,221 @@
+#pragma once
+
+/**
+ * Pondering for bots built on quoridor_bot.cpp: keep searching while the opponents think. Include it after
+ * the template's Player and Wall.
+ *
+ * The server only charges a bot for the time it takes to answer (`Bot.ask` in src/BotWrapper.ts), so every
+ * millisecond between our answer and the next tick is free search time. The template's `main` blocks on
+ * `cin >> tick` for all of it. In pondering mode a TickReader thread waits for the server instead, and a
+ * Ponderer thread searches the position we expect after the opponents' most likely replies:
+ *
+ *     TickReader reader(n);
+ *     TranspositionTable<MyEntry> table(22);
+ *     Ponderer ponderer; // after the table, it is stopped before the table is destroyed
+ *     uint64_t predicted = 0;
+ *     while (optional<TickMessage> message = reader.next()) {
+ *         ponderer.stop();
+ *         GameState my_state = GameState(n, player_id, m, message->players, message->walls).rotate_to_top();
+ *         uint64_t key = my_key(my_state);
+ *         table.end_ponder(key == predicted, total_walls(message->players));
+ *         ... search my_state with `table`, answer ...
+ *         GameState expected = ... my move and the predicted replies ...;
+ *         predicted = my_key(expected);
+ *         table.begin_ponder();
+ *         ponderer.start([&, expected](const atomic<bool> &stop) { search(expected, table, stop); });
+ *     }
+ *
+ * The main thread and the pondering thread never use the table at the same time: the main thread only
+ * touches it between `ponderer.stop()` and `ponderer.start()`, so the table needs no locking. The pondering
+ * search must not write to stdout, the server would take its output for the next answer.
+ *
+ * Pondering needs the CPU while the opponents think. A match run with `suspendIdleBots` (src/common.ts)
+ * stops the bot with SIGSTOP after every answer, so nothing is searched between the ticks there.
+ */
+
+#include <bits/stdc++.h>
+
+using namespace std;
+
+/** What the server sends at the start of our turn */
+struct TickMessage {
+    int tick;
+    vector<Player> players;
+    vector<Wall> walls;
+};
+
+/** Reads the ticks from stdin on its own thread, after the initial lines were read by the main thread */
+class TickReader {
+public:
+    explicit TickReader(int n) : reader([this, n] { read(n); }) {}
+
+    TickReader(const TickReader &) = delete;
+
+    TickReader &operator=(const TickReader &) = delete;
+
+    ~TickReader() {
+        // Before the end of the match the thread is blocked on stdin, and the process is about to exit anyway
+        bool done;
+        {
+            lock_guard<mutex> lock(guard);
+            done = finished;
+        }
+        if (done)
+            reader.join();
+        else
+            reader.detach();
+    }
+
+    /** Waits for the next tick, nullopt once the match is over */
+    optional<TickMessage> next() {
+        unique_lock<mutex> lock(guard);
+        arrived.wait(lock, [this] { return !messages.empty() || finished; });
+        if (messages.empty())
+            return nullopt;
+        TickMessage message = move(messages.front());
+        messages.pop_front();
+        return message;
+    }
+
+private:
+    mutex guard;
+    condition_variable arrived;
+    deque<TickMessage> messages;
+    bool finished = false;
+    thread reader;
+
+    void read(int n) {
+        for (int tick; cin >> tick && tick > -1;) {
+            TickMessage message{tick, vector<Player>(n), {}};
+            for (Player &player: message.players)
+                cin >> player.x >> player.y >> player.walls;
+            int f;
+            cin >> f;
+            message.walls.resize(f);
+            int unused_who;
+            for (Wall &wall: message.walls)
+                cin >> wall.x >> wall.y >> wall.is_vertical >> unused_who;
+            if (!cin)
+                break;
+            lock_guard<mutex> lock(guard);
+            messages.push_back(move(message));
+            arrived.notify_one();
+        }
+        lock_guard<mutex> lock(guard);
+        finished = true;
+        arrived.notify_one();
+    }
+};
+
+/** Runs one search at a time on a background thread */
+class Ponderer {
+public:
+    Ponderer() = default;
+
+    Ponderer(const Ponderer &) = delete;
+
+    Ponderer &operator=(const Ponderer &) = delete;
+
+    ~Ponderer() { stop(); }
+
+    /**
+     * Starts `search` on the pondering thread. It should search deeper and deeper until `stop` is set and
+     * then return quickly, as the main thread waits for it before answering the next tick.
+     */
+    void start(function<void(const atomic<bool> &)> search) {
+        stop();
+        stopping = false;
+        worker = thread([this, search = move(search)] { search(stopping); });
+    }
+
+    /** Stops the running search and waits for it */
+    void stop() {
+        stopping = true;
+        if (worker.joinable())
+            worker.join();
+    }
+
+    bool running() const { return worker.joinable(); }
+
+private:
+    atomic<bool> stopping{false};
+    thread worker;
+};
+
+/**
+ * A fixed size hash table of search results, kept from tick to tick. `Value` is the bot's own entry (depth,
+ * score, best move...). Entries remember when they were stored, so a failed prediction only throws away
+ * what the pondering search found, and the positions that can no longer occur are dropped as the walls
+ * run out. Nothing is swept for that, which would cost the bot its own time after the tick arrived: `find`
+ * just ignores the entries of discarded generations and the ones with too many walls left.
+ */
+template<typename Value>
+class TranspositionTable {
+public:
+    /** A table of 2^log2_size entries */
+    explicit TranspositionTable(int log2_size) : mask((size_t(1) << log2_size) - 1), slots(mask + 1) {}
+
+    Value *find(uint64_t key) {
+        Slot &slot = slots[key & mask];
+        if (slot.generation < first_valid || slot.key != key || discarded[slot.generation] ||
+            slot.walls_left > walls_limit) {
+            return nullptr;
+        }
+        return &slot.value;
+    }
+
+    /** `walls_left` is the number of walls all players still have in the position */
+    void store(uint64_t key, int walls_left, const Value &value) {
+        slots[key & mask] = {key, generation, uint16_t(walls_left), value};
+    }
+
+    /** Called before starting the pondering search, everything it stores can be told apart */
+    void begin_ponder() { next_generation(); }
+
+    /**
+     * Called when the tick arrived and pondering was stopped. On a hit the pondering search was looking at
+     * the right position, so its entries are kept. On a miss they belong to a game that did not happen and
+     * are dropped. Either way the positions with more walls left than `walls_left` are gone for good.
+     */
+    void end_ponder(bool hit, int walls_left) {
+        if (!hit)
+            discarded[generation] = true;
+        walls_limit = min(walls_limit, walls_left);
+        next_generation();
+    }
+
+    void clear() {
+        next_generation();
+        first_valid = generation;
+        walls_limit = INT_MAX;
+    }
+
+private:
+    struct Slot {
+        uint64_t key;
+        /** 0 for a slot that was never used */
+        uint32_t generation;
+        uint16_t walls_left;
+        Value value;
+    };
+
+    size_t mask;
+    vector<Slot> slots;
+    uint32_t generation = 1, first_valid = 1;
+    /** Indexed by generation, two of them per tick */
+    vector<bool> discarded = vector<bool>(2, false);
+    int walls_limit = INT_MAX;
+
+    void next_generation() {
+        ++generation;
+        discarded.push_back(false);
+    }
+};
+
+/** Number of walls all players have left, for `TranspositionTable` */
+inline int total_walls(const vector<Player> &players) {
+    int walls = 0;
+    for (const Player &player: players)
+        walls += player.walls;
+    return walls;
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+/**
+ * Exact solver for the pure race at the end of a two player game, when neither player has walls left.
+ * Include it after the template's GameState.
+ *
+ *     if (is_race(my_state)) {
+ *         if (!race) race.emplace(my_state);
+ *         Pos step = race->best_move(my_state.my_pos, opponent_pos);
+ *         my_state.step_command(step.x, step.y);
+ *     }
+ *
+ * The walls cannot change any more, so a bot keeps its `optional<RaceSolver> race` between ticks: the
+ * table covers every pawn placement (a few milliseconds on 9x9, about half a second on 31x31).
+ *
+ * With the walls fixed, the game only depends on the two pawns and the player to move. The solver
+ * computes the distance field of both players once, then solves every placement of the two pawns by
+ * retrograde analysis: starting from the finished positions it walks back along the legal pawn moves,
+ * jumps included, so every position gets its exact result and the number of plies until the end.
+ * Positions neither player can force stay undecided (the losing side keeps the game going forever).
+ */
+
+#include <bits/stdc++.h>
+
+using namespace std;
+
+template<typename State>
+bool is_race(const State &state) {
+    return state.n == 2 && all_of(state.players.begin(), state.players.end(),
+                                  [](const Player &player) { return player.walls == 0; });
+}
+
+class RaceSolver {
+public:
+    static constexpr int WIN = 1, UNDECIDED = 0, LOSS = -1;
+
+    /** `state` must be a `rotate_to_top` state: its player goes for the bottom row, the opponent for the top row */
+    template<typename State>
+    explicit RaceSolver(const State &state) : m(state.m) {
+        if (m * m > MAX_CELLS)
+            throw invalid_argument("board is too large for RaceSolver");
+        for (int y = 0; y < m; ++y) {
+            for (int x = 0; x < m; ++x) {
+                int cell = y * m + x;
+                const auto &borders = state.borders[x][y];
+                blocked[cell * 4 + UP] = borders.top;
+                blocked[cell * 4 + RIGHT] = borders.right;
+                blocked[cell * 4 + DOWN] = borders.bottom;
+                blocked[cell * 4 + LEFT] = borders.left;
+            }
+        }
+        const Player &me = state.players[state.player_id], &opponent = state.players[1 - state.player_id];
+        root = {me.y * m + me.x, opponent.y * m + opponent.x};
+        distance_field(0, [&](int cell) { return cell / m == m - 1; });
+        distance_field(1, [&](int cell) { return cell / m == 0; });
+        solve();
+    }
+
+    /** Result for the side to move: WIN, LOSS or UNDECIDED, with the number of plies until the game ends */
+    pair<int, int> value(Pos me, Pos opponent, bool my_turn) const {
+        int s = state_index(me.y * m + me.x, opponent.y * m + opponent.x, my_turn ? 0 : 1);
+        if (s < 0)
+            return {UNDECIDED, 0};
+        return {result[s], plies[s]};
+    }
+
+    /** Value of the position the solver was built from, for the player to move (the template's player) */
+    pair<int, int> outcome() const {
+        return value(pos(root[0]), pos(root[1]), true);
+    }
+
+    /**
+     * The best step of the template's player: the fastest win, the slowest loss, or in an undecided
+     * position the move that keeps it undecided and gets closest to the goal.
+     */
+    Pos best_move(Pos me, Pos opponent) const {
+        int from = me.y * m + me.x, other = opponent.y * m + opponent.x;
+        int moves[8];
+        int count = legal_moves(from, other, moves);
+        int best = -1;
+        tuple<int, int, int> best_rank;
+        for (int i = 0; i < count; ++i) {
+            int s = state_index(moves[i], other, 1);
+            int opponent_result = s < 0 ? UNDECIDED : result[s];
+            // Rank lexicographically, higher is better
+            tuple<int, int, int> rank = {-opponent_result, opponent_result == LOSS ? -plies[s] : opponent_result == WIN ? plies[s] : 0,
+                                         -distance[0][moves[i]]};
+            if (best < 0 || rank > best_rank) {
+                best = moves[i];
+                best_rank = rank;
+            }
+        }
+        return best < 0 ? me : pos(best);
+    }
+
+    Pos best_move() const {
+        return best_move(pos(root[0]), pos(root[1]));
+    }
+
+private:
+    enum Direction { UP, RIGHT, DOWN, LEFT };
+
+    static constexpr int MAX_CELLS = 31 * 31;
+
+    int m;
+    bitset<MAX_CELLS * 4> blocked;
+    /** Distance from the goal of each side with the pawns ignored, -1 if unreachable */
+    array<vector<int>, 2> distance;
+    /** Index of every reachable cell of each side, -1 for the rest */
+    array<vector<int>, 2> cell_index;
+    array<int, 2> cell_count{};
+    array<int, 2> root{};
+    vector<int8_t> result;
+    vector<int16_t> plies;
+
+    Pos pos(int cell) const { return {cell % m, cell / m}; }
+
+    int neighbor(int cell, int direction) const {
+        static const int dx[] = {0, 1, 0, -1}, dy[] = {-1, 0, 1, 0};
+        return cell + dy[direction] * m + dx[direction];
+    }
+
+    bool open(int cell, int direction) const { return !blocked[cell * 4 + direction]; }
+
+    template<typename IsGoal>
+    void distance_field(int side, IsGoal is_goal) {
+        vector<int> &field = distance[side];
+        field.assign(m * m, -1);
+        vector<int> queue;
+        for (int cell = 0; cell < m * m; ++cell) {
+            if (is_goal(cell)) {
+                field[cell] = 0;
+                queue.push_back(cell);
+            }
+        }
+        for (size_t i = 0; i < queue.size(); ++i) {
+            for (int direction = 0; direction < 4; ++direction) {
+                if (!open(queue[i], direction))
+                    continue;
+                int next = neighbor(queue[i], direction);
+                if (field[next] < 0) {
+                    field[next] = field[queue[i]] + 1;
+                    queue.push_back(next);
+                }
+            }
+        }
+        cell_index[side].assign(m * m, -1);
+        for (int cell = 0; cell < m * m; ++cell) {
+            if (field[cell] >= 0)
+                cell_index[side][cell] = cell_count[side]++;
+        }
+    }
+
+    /** Same rules as `possibleMoves` in src/quoridor.ts, for two pawns */
+    int legal_moves(int from, int other, int *moves) const {
+        int count = 0;
+        for (int direction = 0; direction < 4; ++direction) {
+            if (!open(from, direction))
+                continue;
+            int next = neighbor(from, direction);
+            if (next != other) {
+                moves[count++] = next;
+            } else if (open(next, direction)) {
+                moves[count++] = neighbor(next, direction);
+            } else {
+                for (int side: {(direction + 1) % 4, (direction + 3) % 4}) {
+                    if (open(next, side))
+                        moves[count++] = neighbor(next, side);
+                }
+            }
+        }
+        return count;
+    }
+
+    /** Index of the position with the pawn of side 0 on `cell0`, -1 if there is no such position */
+    int state_index(int cell0, int cell1, int to_move) const {
+        if (cell0 == cell1 || cell_index[0][cell0] < 0 || cell_index[1][cell1] < 0)
+            return -1;
+        return (cell_index[0][cell0] * cell_count[1] + cell_index[1][cell1]) * 2 + to_move;
+    }
+
+    void solve() {
+        vector<int> cells[2];
+        for (int side = 0; side < 2; ++side) {
+            for (int cell = 0; cell < m * m; ++cell) {
+                if (cell_index[side][cell] >= 0)
+                    cells[side].push_back(cell);
+            }
+        }
+        size_t num_states = size_t(cell_count[0]) * cell_count[1] * 2;
+        result.assign(num_states, UNDECIDED);
+        plies.assign(num_states, 0);
+        vector<uint8_t> remaining(num_states, 0);
+        vector<int> queue;
+        int moves[8];
+        for (int cell0: cells[0]) {
+            for (int cell1: cells[1]) {
+                if (cell0 == cell1)
+                    continue;
+                int cell[2] = {cell0, cell1};
+                for (int to_move = 0; to_move < 2; ++to_move) {
+                    int s = state_index(cell0, cell1, to_move);
+                    if (distance[1 - to_move][cell[1 - to_move]] == 0) {
+                        result[s] = LOSS;
+                        queue.push_back(s);
+                    } else if (distance[to_move][cell[to_move]] == 0) {
+                        result[s] = WIN;
+                        queue.push_back(s);
+                    } else {
+                        remaining[s] = legal_moves(cell[to_move], cell[1 - to_move], moves);
+                    }
+                }
+            }
+        }
+
+        // Walk back from the decided positions. The queue is ordered by plies, so a win is found by its
+        // shortest line and a loss is decided by its longest one.
+        for (size_t i = 0; i < queue.size(); ++i) {
+            int s = queue[i], to_move = s % 2, pair_index = s / 2;
+            int cell[2] = {cells[0][pair_index / cell_count[1]], cells[1][pair_index % cell_count[1]]};
+            int mover = 1 - to_move; // the side that moved into this position
+            int target = cell[mover], other = cell[to_move];
+            if (distance[to_move][other] == 0)
+                continue;
+            for (int dy = -2; dy <= 2; ++dy) {
+                for (int dx = -2 + abs(dy); dx <= 2 - abs(dy); ++dx) {
+                    int x = target % m + dx, y = target / m + dy;
+                    if ((dx == 0 && dy == 0) || x < 0 || x >= m || y < 0 || y >= m)
+                        continue;
+                    int from = y * m + x;
+                    if (from == other || distance[mover][from] <= 0)
+                        continue;
+                    int count = legal_moves(from, other, moves);
+                    if (find(moves, moves + count, target) == moves + count)
+                        continue;
+                    int predecessor = mover == 0 ? state_index(from, other, 0) : state_index(other, from, 1);
+                    if (result[predecessor] != UNDECIDED)
+                        continue;
+                    if (result[s] == LOSS) {
+                        result[predecessor] = WIN;
+                        plies[predecessor] = plies[s] + 1;
+                        queue.push_back(predecessor);
+                    } else if (--remaining[predecessor] == 0) {
+                        result[predecessor] = LOSS;
+                        plies[predecessor] = plies[s] + 1;
+                        queue.push_back(predecessor);
+                    }
+                }
+            }
+        }
+    }
+};
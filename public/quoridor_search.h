@@ -0,0 +1,347 @@
+#pragma once
+
+/**
+ * A game state for tree search in bots built on quoridor_bot.cpp, played forward and back with
+ * `make_move` and `unmake_move`. Include it after the template's GameState.
+ *
+ *     SearchState search(my_state);
+ *     Pos steps[SearchState::MAX_STEPS];
+ *     for (int i = 0, count = search.legal_steps(steps); i < count; ++i) {
+ *         search.make_move({false, steps[i].x, steps[i].y, false});
+ *         int score = -negamax(search, depth - 1);
+ *         search.unmake_move();
+ *     }
+ *
+ * Copying the template's GameState for every hypothetical costs a few heap allocations and a rebuild of
+ * the borders. SearchState is built once per tick: making a move updates the position hash and the
+ * players' distances from their goals in place, and every move pushes what it changed onto an undo stack
+ * of MAX_DEPTH entries allocated up front. Nothing is allocated while searching.
+ *
+ * The distance of every cell from every goal side in use is kept up to date. A wall only changes the
+ * distances of the cells that lose their last shortest step to the goal and of the cells behind them, so
+ * only those are found and relabeled, and their old distances go on a change stack for `unmake_move`.
+ */
+
+#include <bits/stdc++.h>
+#include "quoridor_bitboard.h"
+#include "quoridor_book.h"
+
+using namespace std;
+
+struct Move {
+    bool is_wall;
+    int x, y;
+    bool is_vertical;
+};
+
+class SearchState {
+public:
+    static constexpr int MAX_DEPTH = 64;
+    static constexpr int MAX_PLAYERS = 4;
+    /** Straight steps and jumps in four directions, two of them diagonal at most */
+    static constexpr int MAX_STEPS = 8;
+
+    /** `state` must be a `rotate_to_top` state, its player moves first */
+    template<typename State>
+    explicit SearchState(const State &state)
+        : m(state.m), n(state.n), player(state.player_id), graph(state),
+          affected_mark(state.m * state.m), affected(state.m * state.m), tentative(state.m * state.m),
+          bucket_head(state.m * state.m + 1, -1), entry_cell(5 * state.m * state.m),
+          entry_next(5 * state.m * state.m) {
+        if (n > MAX_PLAYERS)
+            throw invalid_argument("too many players for SearchState");
+        offsets = {-m, 1, m, -1};
+        for (int i = 0; i < n; ++i) {
+            pawns[i] = {state.players[i].x, state.players[i].y};
+            walls_left[i] = state.players[i].walls;
+            goals[i] = goal_side(state, i);
+            sides_used |= 1 << goals[i];
+        }
+        for (const Wall &wall: state.walls)
+            taken.set(graph.wall_slot(wall));
+        for (int side = 0; side < 4; ++side) {
+            if (sides_used >> side & 1) {
+                field[side].resize(m * m);
+                flood(Side(side));
+            }
+        }
+        changes.reserve(size_t(MAX_DEPTH) * __builtin_popcount(sides_used) * m * m);
+        key = zobrist_board(m, n) ^ zobrist_to_move(player);
+        for (int i = 0; i < n; ++i)
+            key ^= zobrist_pawn(i, pawns[i].x, pawns[i].y) ^ zobrist_walls_left(i, walls_left[i]);
+        for (const Wall &wall: state.walls)
+            key ^= zobrist_wall(wall.x, wall.y, wall.is_vertical);
+    }
+
+    int to_move() const { return player; }
+
+    int depth() const { return undo_depth; }
+
+    uint64_t hash() const { return key; }
+
+    Pos pawn(int i) const { return pawns[i]; }
+
+    int walls(int i) const { return walls_left[i]; }
+
+    /** Length of the shortest path of the player to their goal, pawns ignored. -1 for a player out of the game. */
+    int distance(int i) const {
+        return pawns[i].x < 0 ? -1 : field[goals[i]][pawns[i].y * m + pawns[i].x];
+    }
+
+    /** Whether the player to move has a wall for this slot and it does not cross a placed wall */
+    bool can_place(const Wall &wall) const {
+        if (walls_left[player] == 0 || wall.x < 0 || wall.y < 0 || wall.x >= m - 1 || wall.y >= m - 1)
+            return false;
+        auto is_taken = [&](int x, int y, bool is_vertical) {
+            return x >= 0 && y >= 0 && x < m - 1 && y < m - 1 && taken[graph.wall_slot({x, y, is_vertical})];
+        };
+        if (is_taken(wall.x, wall.y, false) || is_taken(wall.x, wall.y, true))
+            return false;
+        if (wall.is_vertical)
+            return !is_taken(wall.x, wall.y - 1, true) && !is_taken(wall.x, wall.y + 1, true);
+        return !is_taken(wall.x - 1, wall.y, false) && !is_taken(wall.x + 1, wall.y, false);
+    }
+
+    /** The steps of the player to move with the same rules as the server, jumps included. Returns the count. */
+    int legal_steps(Pos *steps) const {
+        static const Side directions[] = {TOP, RIGHT, BOTTOM, LEFT};
+        Pos from = pawns[player];
+        int count = 0;
+        for (Side direction: directions) {
+            if (!graph.can_step(from, direction))
+                continue;
+            Pos next = step(from, direction);
+            if (!pawn_on(next)) {
+                steps[count++] = next;
+            } else if (graph.can_step(next, direction)) {
+                Pos beyond = step(next, direction);
+                if (!pawn_on(beyond))
+                    steps[count++] = beyond;
+            } else {
+                for (Side side: {Side((direction + 1) % 4), Side((direction + 3) % 4)}) {
+                    if (graph.can_step(next, side) && !pawn_on(step(next, side)))
+                        steps[count++] = step(next, side);
+                }
+            }
+        }
+        return count;
+    }
+
+    /**
+     * Plays a move of the player to move. Steps are not checked, take them from `legal_steps`. A wall has
+     * to pass `can_place`; if it cuts a pawn off its goal, the state is left as it was and false is returned.
+     */
+    bool make_move(const Move &move) {
+        if (undo_depth == MAX_DEPTH)
+            throw length_error("search deeper than SearchState::MAX_DEPTH");
+        Undo &undo = undo_stack[undo_depth++];
+        undo = {move, player, pawns[player], key, changes.size()};
+        if (move.is_wall) {
+            Wall wall{move.x, move.y, move.is_vertical};
+            graph.place_wall(wall);
+            taken.set(graph.wall_slot(wall));
+            key ^= zobrist_wall(wall.x, wall.y, wall.is_vertical) ^ zobrist_walls_left(player, walls_left[player]) ^
+                   zobrist_walls_left(player, walls_left[player] - 1);
+            --walls_left[player];
+            for (int side = 0; side < 4; ++side) {
+                if (sides_used >> side & 1)
+                    repair(side, wall);
+            }
+            for (int i = 0; i < n; ++i) {
+                if (pawns[i].x >= 0 && distance(i) < 0) {
+                    unmake_move();
+                    return false;
+                }
+            }
+        } else {
+            key ^= zobrist_pawn(player, pawns[player].x, pawns[player].y) ^ zobrist_pawn(player, move.x, move.y);
+            pawns[player] = {move.x, move.y};
+        }
+        // Like the server's nextPlayer, players out of the game are skipped. The mover is on the undo stack.
+        int next_player = (player + 1) % n;
+        while (pawns[next_player].x < 0 && next_player != player)
+            next_player = (next_player + 1) % n;
+        key ^= zobrist_to_move(player) ^ zobrist_to_move(next_player);
+        player = next_player;
+        return true;
+    }
+
+    void unmake_move() {
+        const Undo &undo = undo_stack[--undo_depth];
+        player = undo.player;
+        key = undo.key;
+        if (undo.move.is_wall) {
+            Wall wall{undo.move.x, undo.move.y, undo.move.is_vertical};
+            graph.remove_wall(wall);
+            taken.reset(graph.wall_slot(wall));
+            ++walls_left[player];
+            for (; changes.size() > undo.changes_begin; changes.pop_back())
+                field[changes.back().side][changes.back().cell] = changes.back().distance;
+        } else {
+            pawns[player] = undo.pawn;
+        }
+    }
+
+private:
+    struct Undo {
+        Move move;
+        int player;
+        Pos pawn;
+        uint64_t key;
+        /** Where the distance changes of the move start on `changes` */
+        size_t changes_begin;
+    };
+
+    struct Change {
+        int side, cell;
+        int16_t distance;
+    };
+
+    int m, n, player;
+    BoardGraph graph;
+    array<Pos, MAX_PLAYERS> pawns{};
+    array<int, MAX_PLAYERS> walls_left{};
+    array<Side, MAX_PLAYERS> goals{};
+    int sides_used = 0;
+    BoardGraph::WallSlots taken;
+    /** Distance of every cell from each goal side in use, -1 if the side cannot be reached */
+    array<vector<int16_t>, 4> field;
+    uint64_t key = 0;
+    array<Undo, MAX_DEPTH> undo_stack;
+    int undo_depth = 0;
+    /** The distances replaced by the walls on the undo stack, the latest at the back */
+    vector<Change> changes;
+    /** Cell index offsets of the steps, by Side */
+    array<int, 4> offsets{};
+    /** Scratch space of `repair`, by cell */
+    vector<int> affected_mark, affected, tentative;
+    int repair_runs = 0;
+    /** Buckets of cells by tentative distance, as linked lists of entries */
+    vector<int> bucket_head, entry_cell, entry_next;
+
+    static uint64_t zobrist_to_move(int player) { return zobrist_key(5ULL << 40 | uint64_t(player)); }
+
+    static Pos step(Pos from, Side direction) {
+        static const int dx[] = {0, 1, 0, -1}, dy[] = {-1, 0, 1, 0};
+        return {from.x + dx[direction], from.y + dy[direction]};
+    }
+
+    bool pawn_on(Pos pos) const {
+        for (int i = 0; i < n; ++i) {
+            if (pawns[i].x == pos.x && pawns[i].y == pos.y)
+                return true;
+        }
+        return false;
+    }
+
+    /** Breadth-first distances from the side, one layer of the bitboard at a time */
+    void flood(Side side) {
+        vector<int16_t> &distances = field[side];
+        fill(distances.begin(), distances.end(), -1);
+        Bitboard visited = graph.goal(side), frontier = visited;
+        for (int16_t depth = 0; frontier.any(); ++depth) {
+            for (int i = 0; i < Bitboard::WORDS; ++i) {
+                for (uint64_t word = frontier.words[i]; word; word &= word - 1)
+                    distances[i * 64 + __builtin_ctzll(word)] = depth;
+            }
+            frontier = graph.neighbors(frontier).without(visited);
+            visited |= frontier;
+        }
+    }
+
+    /**
+     * Updates the distances from the side after the wall was placed. Walls only make distances grow, and
+     * a cell keeps its distance as long as it has a step to a cell one closer that keeps its own. The
+     * cells that lose it are found starting from the ends of the removed edges, then relabeled in order
+     * of distance from the cells around them (Dial's buckets, the steps all have length 1).
+     */
+    void repair(int side, const Wall &wall) {
+        vector<int16_t> &distances = field[side];
+        int run = ++repair_runs, count = 0;
+        int cell = wall.y * m + wall.x;
+        int offset = wall.is_vertical ? 1 : m;
+        int other = wall.is_vertical ? m : 1;
+        for (int from: {cell, cell + other}) {
+            for (auto [a, b]: {pair<int, int>{from, from + offset}, pair<int, int>{from + offset, from}}) {
+                if (distances[a] > 0 && distances[a] == distances[b] + 1 && affected_mark[a] != run &&
+                    !has_closer_step(distances, a, run)) {
+                    affected_mark[a] = run;
+                    affected[count++] = a;
+                }
+            }
+        }
+        // The cells one farther that had their only closer step through an affected cell
+        for (int i = 0; i < count; ++i) {
+            for (int direction = 0; direction < 4; ++direction) {
+                if (!can_step(affected[i], direction))
+                    continue;
+                int next = affected[i] + offsets[direction];
+                if (affected_mark[next] != run && distances[next] == distances[affected[i]] + 1 &&
+                    !has_closer_step(distances, next, run)) {
+                    affected_mark[next] = run;
+                    affected[count++] = next;
+                }
+            }
+        }
+        if (count == 0)
+            return;
+
+        const int unreachable = m * m;
+        int entries = 0, first_bucket = unreachable, last_bucket = -1;
+        auto push = [&](int cell, int distance) {
+            entry_cell[entries] = cell;
+            entry_next[entries] = bucket_head[distance];
+            bucket_head[distance] = entries++;
+            first_bucket = min(first_bucket, distance);
+            last_bucket = max(last_bucket, distance);
+        };
+        for (int i = 0; i < count; ++i) {
+            int cell = affected[i];
+            tentative[cell] = unreachable;
+            for (int direction = 0; direction < 4; ++direction) {
+                int next = cell + offsets[direction];
+                if (can_step(cell, direction) && affected_mark[next] != run && distances[next] >= 0)
+                    tentative[cell] = min(tentative[cell], distances[next] + 1);
+            }
+            if (tentative[cell] < unreachable)
+                push(cell, tentative[cell]);
+        }
+        for (int distance = first_bucket; distance <= last_bucket; ++distance) {
+            for (int entry = bucket_head[distance]; entry >= 0; entry = entry_next[entry]) {
+                int cell = entry_cell[entry];
+                // Relabeled cells are marked with the negative run, stale entries are skipped
+                if (affected_mark[cell] != run || tentative[cell] != distance)
+                    continue;
+                affected_mark[cell] = -run;
+                changes.push_back({side, cell, distances[cell]});
+                distances[cell] = int16_t(distance);
+                for (int direction = 0; direction < 4; ++direction) {
+                    int next = cell + offsets[direction];
+                    if (can_step(cell, direction) && affected_mark[next] == run && tentative[next] > distance + 1) {
+                        tentative[next] = distance + 1;
+                        push(next, distance + 1);
+                    }
+                }
+            }
+            bucket_head[distance] = -1;
+        }
+        for (int i = 0; i < count; ++i) {
+            if (affected_mark[affected[i]] == run) {
+                changes.push_back({side, affected[i], distances[affected[i]]});
+                distances[affected[i]] = -1;
+            }
+        }
+    }
+
+    bool can_step(int cell, int direction) const { return graph.can_step({cell % m, cell / m}, Side(direction)); }
+
+    /** Whether the cell has a step to a cell one closer to the goal that is not affected in this run */
+    bool has_closer_step(const vector<int16_t> &distances, int cell, int run) const {
+        for (int direction = 0; direction < 4; ++direction) {
+            int next = cell + offsets[direction];
+            if (can_step(cell, direction) && affected_mark[next] != run && distances[next] == distances[cell] - 1)
+                return true;
+        }
+        return false;
+    }
+};
@@ -16,6 +16,13 @@ export class BotError extends Error {
   }
 }
 
+export interface BotPlacement {
+  // Pin the process to these CPUs, empty to let it run anywhere
+  cpus?: number[];
+  // Suspend the process between its turns
+  suspendWhenIdle?: boolean;
+}
+
 export class Bot {
   error?: BotError;
   process: ChildProcess;
@@ -23,20 +30,35 @@ export class Bot {
   std_err: string[] = [];
   available_time: number;
   stdin: Writable;
+  readonly cpus: number[];
+  readonly suspendWhenIdle: boolean;
+  private suspended = false;
 
   private static readonly starting_available_time: number = 1000; // in ms
   private static readonly plus_time_per_round: number = 30; // in ms
 
+  // The most the bots of a match can spend answering, in ms, all of them together
+  public static matchTimeBudget(numOfPlayers: number, maxTicks: number): number {
+    return numOfPlayers * Bot.starting_available_time + maxTicks * Bot.plus_time_per_round;
+  }
+
   public constructor(
     readonly id: string,
     readonly name: string,
     readonly index: number,
     command: string,
+    placement: BotPlacement = {},
   ) {
     this.bot = { id, name, index };
     this.available_time = Bot.starting_available_time;
-
-    this.process = spawn(`${command}`, []);
+    this.cpus = placement.cpus ?? [];
+    this.suspendWhenIdle = placement.suspendWhenIdle ?? false;
+
+    // taskset execs the bot, so the affinity holds for every thread the bot starts and the pid
+    // stays the bot's own
+    this.process = this.cpus.length
+      ? spawn("taskset", ["--cpu-list", this.cpus.join(","), command])
+      : spawn(`${command}`, []);
     this.process.on("error", (error) => {
       this.setBotError(new BotError(this.bot, "process error: " + error.message));
     });
@@ -78,6 +100,7 @@ export class Bot {
   public send(message: string) {
     if (this.error)
       throw new BotError(this.bot, "Send failed, already in error state: " + this.error.message);
+    this.resume();
 
     return new Promise<void>((resolve, reject) => {
       try {
@@ -122,6 +145,7 @@ export class Bot {
       await delay(10);
     }
 
+    this.pause();
     const data = this.std_out.length ? this.std_out.splice(0, number_of_lines).join("\n") : null;
     // We don't want to set this.error = TLE and thus drop the player after a single timeout.
     // Maybe after X rounds of continuous timeout, if we want to be that smart.
@@ -140,7 +164,21 @@ export class Bot {
     return this.process.kill(signal);
   }
 
+  // Suspends the process until the next message if the bot is configured so
+  public pause() {
+    if (!this.suspendWhenIdle || this.suspended || this.error) return;
+    this.suspended = this.kill("SIGSTOP");
+  }
+
+  public resume() {
+    if (!this.suspended) return;
+    this.kill("SIGCONT");
+    this.suspended = false;
+  }
+
   public stop() {
+    // A stopped process would only see the signal once continued
+    this.resume();
     this.stdin.end();
     this.kill();
   }
@@ -160,9 +198,10 @@ export class Bot {
 export class BotPool {
   public bots: Bot[];
 
-  public constructor(bot_configs: BotConfig[]) {
+  public constructor(bot_configs: BotConfig[], suspendIdleBots = false) {
     this.bots = bot_configs.map(
-      ({ id, name, runCommand }, index) => new Bot(id, name, index, runCommand),
+      ({ id, name, runCommand, cpus }, index) =>
+        new Bot(id, name, index, runCommand, { cpus, suspendWhenIdle: suspendIdleBots }),
     );
   }
 
@@ -174,6 +213,10 @@ export class BotPool {
     return Promise.all(this.bots.map((b) => b.ask(number_of_lines)));
   }
 
+  public pauseAll() {
+    for (const bot of this.bots) bot.pause();
+  }
+
   public killAll(signal?: NodeJS.Signals | number) {
     for (const bot of this.bots) bot.kill(signal);
   }
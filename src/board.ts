@@ -0,0 +1,416 @@
+import { WallPos } from "./types";
+
+export type Side = "top" | "right" | "bottom" | "left";
+
+interface CutTable {
+  // Flow of 3 edge-disjoint paths to the goal by edge, null if there are no 3 such paths
+  flow: Int8Array | null;
+  // 1 for the wall slots that cut the pawn off its goal
+  cuts: Uint8Array;
+}
+
+// Tables of pawns that moved on are never used again
+const MAX_CACHED_TABLES = 64;
+
+/*
+  Pawn connectivity of the board as multiword bitboards: bit y * size + x of a Uint32Array stands
+  for the cell (x, y), so a whole BFS layer is expanded with a few shifts per word. Boards up to
+  31x31 need 31 words. Which walls would cut a pawn off is kept in a table for all wall slots at
+  once, from the bridges and 2-edge cuts between the pawn and its goal.
+*/
+export class Board {
+  readonly words: number;
+  // Cells from which a pawn can step in the given direction
+  private readonly canUp: Uint32Array;
+  private readonly canRight: Uint32Array;
+  private readonly canDown: Uint32Array;
+  private readonly canLeft: Uint32Array;
+  private readonly steps: [Uint32Array, number][];
+  private readonly goals = new Map<Side, Uint32Array>();
+  // Cut tables by pawn position and goal
+  private readonly cutCache = new Map<string, CutTable>();
+  private readonly frontier: Uint32Array;
+  private readonly visited: Uint32Array;
+  private readonly next: Uint32Array;
+  private readonly shifted: Uint32Array;
+  // Scratch space of augment(), by cell
+  private readonly queue: Int32Array;
+  private readonly parentEdge: Int32Array;
+  private readonly parentOffset: Int32Array;
+  private readonly seen: Int32Array;
+  private seenRuns = 0;
+  // Scratch space of findBridges(), by node
+  private readonly discovered: Int32Array;
+  private readonly low: Int32Array;
+  private readonly reachesGoal: Uint8Array;
+  private readonly stackNode: Int32Array;
+  private readonly stackEdge: Int32Array;
+  private readonly stackNext: Int32Array;
+  // By edge, the last findBridges() run that found it to be a bridge
+  private readonly bridgeMark: Int32Array;
+  private bridgeRuns = 0;
+
+  public constructor(readonly size: number) {
+    this.words = Math.ceil((size * size) / 32);
+    this.canUp = new Uint32Array(this.words);
+    this.canRight = new Uint32Array(this.words);
+    this.canDown = new Uint32Array(this.words);
+    this.canLeft = new Uint32Array(this.words);
+    this.frontier = new Uint32Array(this.words);
+    this.visited = new Uint32Array(this.words);
+    this.next = new Uint32Array(this.words);
+    this.shifted = new Uint32Array(this.words);
+    const cells = size * size;
+    this.queue = new Int32Array(cells);
+    this.parentEdge = new Int32Array(cells);
+    this.parentOffset = new Int32Array(cells);
+    this.seen = new Int32Array(cells);
+    this.discovered = new Int32Array(cells + 1);
+    this.low = new Int32Array(cells + 1);
+    this.reachesGoal = new Uint8Array(cells + 1);
+    this.stackNode = new Int32Array(cells + 1);
+    this.stackEdge = new Int32Array(cells + 1);
+    this.stackNext = new Int32Array(cells + 1);
+    this.bridgeMark = new Int32Array(3 * cells);
+    this.steps = [
+      [this.canRight, 1],
+      [this.canLeft, -1],
+      [this.canDown, size],
+      [this.canUp, -size],
+    ];
+    for (let y = 0; y < size; y++) {
+      for (let x = 0; x < size; x++) {
+        if (y > 0) setBit(this.canUp, y * size + x);
+        if (x < size - 1) setBit(this.canRight, y * size + x);
+        if (y < size - 1) setBit(this.canDown, y * size + x);
+        if (x > 0) setBit(this.canLeft, y * size + x);
+      }
+    }
+  }
+
+  public placeWall(wall: WallPos) {
+    this.setWall(wall, true);
+    const [first, second] = this.wallEdges(wall.x, wall.y, wall.isVertical);
+    for (const [key, table] of this.cutCache) {
+      if (table.flow === null || table.flow[first] !== 0 || table.flow[second] !== 0) {
+        this.cutCache.delete(key);
+      }
+    }
+  }
+
+  /*
+    Length of the shortest path from (x, y) to the given side of the board, pawns ignored.
+    Returns -1 if there is no path.
+  */
+  public distance(x: number, y: number, side: Side): number {
+    if (x < 0) return -1;
+    const goal = this.goal(side);
+    this.frontier.fill(0);
+    setBit(this.frontier, y * this.size + x);
+    this.visited.set(this.frontier);
+    for (let depth = 0; ; depth++) {
+      if (intersects(this.frontier, goal)) return depth;
+      if (!this.expand()) return -1;
+    }
+  }
+
+  /*
+    Whether placing the wall would leave the pawn on (x, y) without a path to the given side.
+  */
+  public wallCutsOff(x: number, y: number, side: Side, wall: WallPos): boolean {
+    return this.cuttingWalls(x, y, side)[this.wallSlot(wall.x, wall.y, wall.isVertical)] === 1;
+  }
+
+  /*
+    The wall slots that would cut the pawn on (x, y) off the given side: 1 at wallSlot() of every
+    such wall. Slots that overlap the walls on the board are meaningless. A wall takes two edges out
+    of the board, so it cuts the pawn off if one of them is a bridge between the pawn and the side,
+    or if the two edges together are a cut. When there are 3 edge-disjoint paths to the side no wall
+    can do that, and the table stays valid until a wall is placed on one of those paths.
+  */
+  public cuttingWalls(x: number, y: number, side: Side): Uint8Array {
+    const key = `${x},${y},${side}`;
+    let table = this.cutCache.get(key);
+    if (table === undefined) {
+      if (this.cutCache.size >= MAX_CACHED_TABLES) this.cutCache.clear();
+      table = this.cutTable(y * this.size + x, this.goal(side));
+      this.cutCache.set(key, table);
+    }
+    return table.cuts;
+  }
+
+  public wallSlot(x: number, y: number, isVertical: 0 | 1): number {
+    return (y * (this.size - 1) + x) * 2 + isVertical;
+  }
+
+  private goal(side: Side): Uint32Array {
+    let goal = this.goals.get(side);
+    if (goal === undefined) {
+      goal = new Uint32Array(this.words);
+      for (let i = 0; i < this.size; i++) {
+        const [x, y] =
+          side === "top"
+            ? [i, 0]
+            : side === "bottom"
+            ? [i, this.size - 1]
+            : side === "left"
+            ? [0, i]
+            : [this.size - 1, i];
+        setBit(goal, y * this.size + x);
+      }
+      this.goals.set(side, goal);
+    }
+    return goal;
+  }
+
+  /*
+    One BFS layer: replaces frontier with the unvisited neighbors of frontier and marks them
+    visited. Returns false if there are none.
+  */
+  private expand(): boolean {
+    const { frontier, next, shifted, words } = this;
+    next.fill(0);
+    for (const [mask, offset] of this.steps) {
+      for (let i = 0; i < words; i++) shifted[i] = frontier[i] & mask[i];
+      shiftInPlace(shifted, offset);
+      for (let i = 0; i < words; i++) next[i] |= shifted[i];
+    }
+    let any = 0;
+    for (let i = 0; i < words; i++) {
+      frontier[i] = next[i] & ~this.visited[i];
+      this.visited[i] |= frontier[i];
+      any |= frontier[i];
+    }
+    return any !== 0;
+  }
+
+  /*
+    Edge ids: 2 * cell for the step right of the cell, 2 * cell + 1 for the step down. The links of
+    the goal cells to the goal node of findBridges() come after them.
+  */
+  private edgeId(cell: number, offset: number): number {
+    const from = offset > 0 ? cell : cell + offset;
+    return 2 * from + (Math.abs(offset) === 1 ? 0 : 1);
+  }
+
+  // The two edges a wall takes out
+  private wallEdges(x: number, y: number, isVertical: 0 | 1): [number, number] {
+    const cell = y * this.size + x;
+    return isVertical === 1
+      ? [2 * cell, 2 * (cell + this.size)]
+      : [2 * cell + 1, 2 * (cell + 1) + 1];
+  }
+
+  private cutTable(source: number, goal: Uint32Array): CutTable {
+    const cuts = new Uint8Array(2 * (this.size - 1) * (this.size - 1));
+    const flow = new Int8Array(2 * this.size * this.size);
+    if (testBit(goal, source)) return { flow, cuts };
+    const path: number[] = [];
+    let paths = 0;
+    while (paths < 3 && this.augment(source, goal, flow, paths === 0 ? path : null)) paths++;
+    if (paths === 3) return { flow, cuts };
+    if (paths === 0) return { flow: null, cuts: cuts.fill(1) };
+
+    // A wall that leaves the path alone cannot cut the pawn off, so only the edges of the path
+    // are taken out one by one, looking for the bridges that are left
+    const goalCells: number[] = [];
+    for (let cell = 0; cell < this.size * this.size; cell++) {
+      if (testBit(goal, cell)) goalCells.push(cell);
+    }
+    const run = this.findBridges(source, goal, goalCells, -1);
+    const isBridge = path.map((edge) => this.bridgeMark[edge] === run);
+    path.forEach((edge, i) => {
+      const cell = edge >> 1;
+      const x = cell % this.size;
+      const y = Math.floor(cell / this.size);
+      const walls: [number, number, 0 | 1][] =
+        (edge & 1) === 0
+          ? [
+              [x, y, 1],
+              [x, y - 1, 1],
+            ]
+          : [
+              [x, y, 0],
+              [x - 1, y, 0],
+            ];
+      const edgeRun = isBridge[i] ? 0 : this.findBridges(source, goal, goalCells, edge);
+      for (const [wx, wy, isVertical] of walls) {
+        if (wx < 0 || wy < 0 || wx >= this.size - 1 || wy >= this.size - 1) continue;
+        const [first, second] = this.wallEdges(wx, wy, isVertical);
+        const partner = first === edge ? second : first;
+        if (isBridge[i] || edgeRun < 0 || this.bridgeMark[partner] === edgeRun) {
+          cuts[this.wallSlot(wx, wy, isVertical)] = 1;
+        }
+      }
+    });
+    return { flow: null, cuts };
+  }
+
+  /*
+    Pushes one more unit of flow from the source to the goal along a shortest augmenting path, the
+    edges being undirected with capacity 1. Appends the edges of that path to `path` if it is given.
+    Returns false if the flow is already maximal.
+  */
+  private augment(
+    source: number,
+    goal: Uint32Array,
+    flow: Int8Array,
+    path: number[] | null,
+  ): boolean {
+    const { queue, parentEdge, parentOffset, seen } = this;
+    const stamp = ++this.seenRuns;
+    queue[0] = source;
+    seen[source] = stamp;
+    for (let i = 0, end = 1; i < end; i++) {
+      const cell = queue[i];
+      if (testBit(goal, cell)) {
+        for (let c = cell; c !== source; c -= parentOffset[c]) {
+          flow[parentEdge[c]] += parentOffset[c] > 0 ? 1 : -1;
+          path?.push(parentEdge[c]);
+        }
+        return true;
+      }
+      for (const [mask, offset] of this.steps) {
+        const next = cell + offset;
+        if (!testBit(mask, cell) || seen[next] === stamp) continue;
+        // Flow is counted positive from the lower cell to the higher one
+        const edge = this.edgeId(cell, offset);
+        if (flow[edge] === (offset > 0 ? 1 : -1)) continue;
+        seen[next] = stamp;
+        parentEdge[next] = edge;
+        parentOffset[next] = offset;
+        queue[end++] = next;
+      }
+    }
+    return false;
+  }
+
+  /*
+    Tarjan's bridge search from the source on the board without the `removed` edge, with one extra
+    node linked to every goal cell. Marks the bridges that separate the source from the goal with
+    the returned run number in bridgeMark. Returns -1 if the source cannot reach the goal at all.
+  */
+  private findBridges(
+    source: number,
+    goal: Uint32Array,
+    goalCells: number[],
+    removed: number,
+  ): number {
+    const run = ++this.bridgeRuns;
+    const goalNode = this.size * this.size;
+    const { discovered, low, reachesGoal, stackNode, stackEdge, stackNext } = this;
+    discovered.fill(-1);
+    let time = 0;
+    discovered[source] = low[source] = time++;
+    reachesGoal[source] = 0;
+    stackNode[0] = source;
+    stackEdge[0] = -1;
+    stackNext[0] = 0;
+    let top = 1;
+    while (top > 0) {
+      const node = stackNode[top - 1];
+      const i = stackNext[top - 1]++;
+      let next = -1;
+      let edge = -1;
+      if (node === goalNode) {
+        if (i < goalCells.length) {
+          next = goalCells[i];
+          edge = 2 * goalNode + next;
+        }
+      } else if (i < 4) {
+        const [mask, offset] = this.steps[i];
+        if (!testBit(mask, node)) continue;
+        next = node + offset;
+        edge = this.edgeId(node, offset);
+        if (edge === removed) continue;
+      } else if (i === 4) {
+        if (!testBit(goal, node)) continue;
+        next = goalNode;
+        edge = 2 * goalNode + node;
+      }
+
+      if (next >= 0) {
+        if (edge === stackEdge[top - 1]) continue;
+        if (discovered[next] >= 0) {
+          low[node] = Math.min(low[node], discovered[next]);
+        } else {
+          discovered[next] = low[next] = time++;
+          reachesGoal[next] = next === goalNode ? 1 : 0;
+          stackNode[top] = next;
+          stackEdge[top] = edge;
+          stackNext[top] = 0;
+          top++;
+        }
+        continue;
+      }
+
+      // All the neighbors are done, back to the parent
+      top--;
+      if (top === 0) break;
+      const parent = stackNode[top - 1];
+      low[parent] = Math.min(low[parent], low[node]);
+      if (reachesGoal[node] === 1) {
+        reachesGoal[parent] = 1;
+        if (low[node] > discovered[parent]) this.bridgeMark[stackEdge[top]] = run;
+      }
+    }
+    return discovered[goalNode] >= 0 ? run : -1;
+  }
+
+  private setWall(wall: WallPos, blocked: boolean) {
+    const update = blocked ? clearBit : setBit;
+    const cell = wall.y * this.size + wall.x;
+    if (wall.isVertical === 1) {
+      update(this.canRight, cell);
+      update(this.canRight, cell + this.size);
+      update(this.canLeft, cell + 1);
+      update(this.canLeft, cell + this.size + 1);
+    } else {
+      update(this.canDown, cell);
+      update(this.canDown, cell + 1);
+      update(this.canUp, cell + this.size);
+      update(this.canUp, cell + this.size + 1);
+    }
+  }
+}
+
+function setBit(bits: Uint32Array, index: number) {
+  bits[index >>> 5] |= 1 << (index & 31);
+}
+
+function clearBit(bits: Uint32Array, index: number) {
+  bits[index >>> 5] &= ~(1 << (index & 31));
+}
+
+function testBit(bits: Uint32Array, index: number): boolean {
+  return index >= 0 && (bits[index >>> 5] & (1 << (index & 31))) !== 0;
+}
+
+function intersects(a: Uint32Array, b: Uint32Array): boolean {
+  for (let i = 0; i < a.length; i++) {
+    if ((a[i] & b[i]) !== 0) return true;
+  }
+  return false;
+}
+
+/*
+  Moves every bit from index i to i + offset, dropping the ones that leave the array.
+*/
+function shiftInPlace(bits: Uint32Array, offset: number) {
+  const wordShift = Math.floor(Math.abs(offset) / 32);
+  const bitShift = Math.abs(offset) % 32;
+  const n = bits.length;
+  if (offset > 0) {
+    for (let i = n - 1; i >= 0; i--) {
+      const low = i - wordShift >= 0 ? bits[i - wordShift] : 0;
+      const lower = bitShift && i - wordShift - 1 >= 0 ? bits[i - wordShift - 1] : 0;
+      bits[i] = bitShift ? (low << bitShift) | (lower >>> (32 - bitShift)) : low;
+    }
+  } else {
+    for (let i = 0; i < n; i++) {
+      const high = i + wordShift < n ? bits[i + wordShift] : 0;
+      const higher = bitShift && i + wordShift + 1 < n ? bits[i + wordShift + 1] : 0;
+      bits[i] = bitShift ? (high >>> bitShift) | (higher << (32 - bitShift)) : high;
+    }
+  }
+}
@@ -1,8 +1,47 @@
 import * as t from "io-ts";
 
-export const botConfigCodec = t.type({ id: t.string, name: t.string, runCommand: t.string });
+export const botConfigCodec = t.intersection([
+  t.type({ id: t.string, name: t.string, runCommand: t.string }),
+  t.partial({
+    // CPUs the bot is pinned to with taskset, for example a dedicated core per bot when several
+    // matches share a host
+    cpus: t.array(t.number),
+  }),
+]);
 export type BotConfig = t.TypeOf<typeof botConfigCodec>;
-export const matchConfigCodec = t.type({
-  map: t.string,
-  bots: t.array(botConfigCodec),
-});
+export const matchConfigCodec = t.intersection([
+  t.type({
+    map: t.string,
+    bots: t.array(botConfigCodec),
+  }),
+  t.partial({
+    // End the match as soon as the race at the end of the game is decided, see src/race.ts
+    stopDecidedGames: t.boolean,
+    // Stop the bot processes with SIGSTOP while it is not their turn. Bots cannot think on the
+    // opponents' time then, but they do not take CPU time from them either. This turns off the
+    // pondering of public/quoridor_ponder.h.
+    suspendIdleBots: t.boolean,
+  }),
+]);
+export const tournamentConfigCodec = t.intersection([
+  t.type({
+    bots: t.array(botConfigCodec),
+  }),
+  t.partial({
+    // Two player maps, every ordered pair of bots plays on each. Defaults to the default and the
+    // reversed map.
+    maps: t.array(t.string),
+    // Number of times every pairing is played
+    rounds: t.number,
+    // The job queue, on a shared file system if workers run on several machines
+    queueDir: t.string,
+    // Matches played at the same time by one coordinator or worker process
+    workers: t.number,
+    // Give every bot of a worker a CPU of its own
+    pinCpus: t.boolean,
+    stopDecidedGames: t.boolean,
+    // Passed on to the matches, see above: no pondering when set
+    suspendIdleBots: t.boolean,
+  }),
+]);
+export type TournamentConfig = t.TypeOf<typeof tournamentConfigCodec>;
@@ -1,4 +1,5 @@
 import { GameState } from "./types";
+import { Board } from "./board";
 
 const BOARD_SIZE = 9;
 
@@ -17,6 +18,7 @@ export const initStateFour: GameState = {
     ],
     walls: [],
     ownedWalls: [5, 5, 5, 5],
+    board: new Board(BOARD_SIZE),
     // First index is x, second is y
     wallsByCell: Array.from({ length: BOARD_SIZE }, (_, x) =>
       Object(
@@ -53,6 +55,7 @@ export const initStateTwo: GameState = {
     ],
     walls: [],
     ownedWalls: [10, 10],
+    board: new Board(BOARD_SIZE),
     // First index is x, second is y
     wallsByCell: Array.from({ length: BOARD_SIZE }, (_, x) =>
       Object(
@@ -0,0 +1,191 @@
+import * as fs from "fs";
+import * as os from "os";
+import * as path from "path";
+import { BotConfig } from "./common";
+
+/*
+  A job queue in a directory, shared by the coordinator and the workers of a tournament. Workers on
+  other machines use it through a network file system mounted at the same path.
+
+    pending/<job>.json   waiting to be played
+    running/<job>.json   claimed by a worker, which touches the file while the match is running
+    results/<job>.json   finished
+    matches/<job>/       the match config, match.log, score.json and the server's output
+
+  Every state change is a rename, which is atomic on one file system: of two workers claiming the
+  same job only one rename succeeds. A job whose worker stopped touching it is put back to pending,
+  so a crashed worker or machine only costs the match it was playing. The workers' clocks may
+  differ from the coordinator's, so it times the leases from the mtime changes it sees itself.
+*/
+
+export interface Job {
+  id: string;
+  map: string;
+  // In seat order
+  bots: BotConfig[];
+  // Wall clock limit of the match in ms
+  timeLimit: number;
+}
+
+export interface JobResult {
+  id: string;
+  // Same as score.json, null if the match could not be played
+  scores: Record<string, number> | null;
+  error?: string;
+  worker: string;
+  finishedAt: string;
+}
+
+const FINISHED = "finished";
+
+export class JobQueue {
+  // Last mtime seen of every running job and when it was seen, by the local clock
+  private readonly leases = new Map<string, { mtimeMs: number; seenAt: number }>();
+
+  public constructor(readonly dir: string) {
+    for (const sub of ["pending", "running", "results", "matches", "tmp"]) {
+      fs.mkdirSync(path.join(dir, sub), { recursive: true });
+    }
+  }
+
+  // Adds the job unless it is already queued, running or finished
+  public add(job: Job) {
+    const file = `${job.id}.json`;
+    const states = ["pending", "running", "results"];
+    if (states.some((state) => fs.existsSync(path.join(this.dir, state, file)))) return;
+    this.writeAtomic(path.join(this.dir, "pending", file), job);
+  }
+
+  // Drops the pending jobs that are not in `ids`, for example after a bot was removed
+  public prune(ids: Set<string>) {
+    for (const file of fs.readdirSync(path.join(this.dir, "pending"))) {
+      if (ids.has(path.basename(file, ".json"))) continue;
+      this.unlink(path.join(this.dir, "pending", file));
+    }
+  }
+
+  // Forgets the matches that could not be played, so they are tried again
+  public dropFailed() {
+    for (const id of this.finishedIds()) {
+      if (this.result(id)?.scores !== null) continue;
+      this.unlink(path.join(this.dir, "results", `${id}.json`));
+    }
+  }
+
+  // Takes a pending job, null if there is none
+  public claim(): Job | null {
+    for (const file of fs.readdirSync(path.join(this.dir, "pending")).sort()) {
+      const running = path.join(this.dir, "running", file);
+      try {
+        fs.renameSync(path.join(this.dir, "pending", file), running);
+      } catch (error) {
+        // Another worker was faster
+        if ((error as NodeJS.ErrnoException).code === "ENOENT") continue;
+        throw error;
+      }
+      if (fs.existsSync(path.join(this.dir, "results", file))) {
+        // Put back by requeueStale while its worker was finishing it
+        this.unlink(running);
+        continue;
+      }
+      return JSON.parse(fs.readFileSync(running, "utf-8"));
+    }
+    return null;
+  }
+
+  // Renews the lease of a running job
+  public heartbeat(id: string) {
+    const now = new Date();
+    try {
+      fs.utimesSync(path.join(this.dir, "running", `${id}.json`), now, now);
+    } catch {
+      // Taken away by requeueStale, the result is still welcome
+    }
+  }
+
+  public complete(result: JobResult) {
+    this.writeAtomic(path.join(this.dir, "results", `${result.id}.json`), result);
+    this.unlink(path.join(this.dir, "running", `${result.id}.json`));
+  }
+
+  /*
+    Puts back the running jobs that were not touched for `timeoutMs`, returns their number. Only
+    mtime changes count, not their values: `timeoutMs` passes on this process's clock.
+  */
+  public requeueStale(timeoutMs: number): number {
+    let requeued = 0;
+    const files = fs.readdirSync(path.join(this.dir, "running"));
+    for (const file of this.leases.keys()) {
+      if (!files.includes(file)) this.leases.delete(file);
+    }
+    for (const file of files) {
+      const running = path.join(this.dir, "running", file);
+      try {
+        const mtimeMs = fs.statSync(running).mtimeMs;
+        const lease = this.leases.get(file);
+        if (lease === undefined || lease.mtimeMs !== mtimeMs) {
+          this.leases.set(file, { mtimeMs, seenAt: Date.now() });
+          continue;
+        }
+        if (Date.now() - lease.seenAt < timeoutMs) continue;
+        this.leases.delete(file);
+        if (fs.existsSync(path.join(this.dir, "results", file))) {
+          this.unlink(running);
+        } else {
+          fs.renameSync(running, path.join(this.dir, "pending", file));
+          requeued++;
+        }
+      } catch (error) {
+        // Finished or requeued by someone else meanwhile
+        if ((error as NodeJS.ErrnoException).code !== "ENOENT") throw error;
+      }
+    }
+    return requeued;
+  }
+
+  public result(id: string): JobResult | null {
+    const file = path.join(this.dir, "results", `${id}.json`);
+    return fs.existsSync(file) ? JSON.parse(fs.readFileSync(file, "utf-8")) : null;
+  }
+
+  public finishedIds(): string[] {
+    return fs
+      .readdirSync(path.join(this.dir, "results"))
+      .map((file) => path.basename(file, ".json"));
+  }
+
+  public matchDir(id: string): string {
+    return path.join(this.dir, "matches", id);
+  }
+
+  // Tells the workers to exit once the queue is empty
+  public finish() {
+    fs.writeFileSync(path.join(this.dir, FINISHED), "");
+  }
+
+  public reopen() {
+    this.unlink(path.join(this.dir, FINISHED));
+  }
+
+  public isFinished(): boolean {
+    return fs.existsSync(path.join(this.dir, FINISHED));
+  }
+
+  public writeAtomic(file: string, data: unknown) {
+    const tmp = path.join(
+      this.dir,
+      "tmp",
+      `${path.basename(file)}.${os.hostname()}.${process.pid}`,
+    );
+    fs.writeFileSync(tmp, JSON.stringify(data, undefined, 2), "utf-8");
+    fs.renameSync(tmp, file);
+  }
+
+  private unlink(file: string) {
+    try {
+      fs.unlinkSync(file);
+    } catch (error) {
+      if ((error as NodeJS.ErrnoException).code !== "ENOENT") throw error;
+    }
+  }
+}
@@ -63,6 +63,16 @@ export interface Player {
    * @generated from protobuf field: string name = 3;
    */
   name: string;
+  /**
+   * CPUs the bot was pinned to, empty if it could run anywhere
+   *
+   * @generated from protobuf field: repeated int32 cpus = 4;
+   */
+  cpus: number[];
+  /**
+   * @generated from protobuf field: optional bool suspended_when_idle = 5;
+   */
+  suspendedWhenIdle?: boolean;
 }
 /**
  * @generated from protobuf message Tick
@@ -123,6 +133,12 @@ export interface Tick {
    * @generated from protobuf field: repeated Bot bots = 9;
    */
   bots: Bot[];
+  /**
+   * Set on the last tick when the match was stopped early because this player wins the race by force
+   *
+   * @generated from protobuf field: optional int32 race_winner = 10;
+   */
+  raceWinner?: number;
 }
 /**
  * @generated from protobuf message PawnPos
@@ -402,10 +418,18 @@ class Player$Type extends MessageType<Player> {
       { no: 1, name: "id", kind: "scalar", T: 9 /*ScalarType.STRING*/ },
       { no: 2, name: "index", kind: "scalar", T: 5 /*ScalarType.INT32*/ },
       { no: 3, name: "name", kind: "scalar", T: 9 /*ScalarType.STRING*/ },
+      {
+        no: 4,
+        name: "cpus",
+        kind: "scalar",
+        repeat: 1 /*RepeatType.PACKED*/,
+        T: 5 /*ScalarType.INT32*/,
+      },
+      { no: 5, name: "suspended_when_idle", kind: "scalar", opt: true, T: 8 /*ScalarType.BOOL*/ },
     ]);
   }
   create(value?: PartialMessage<Player>): Player {
-    const message = { id: "", index: 0, name: "" };
+    const message = { id: "", index: 0, name: "", cpus: [] };
     globalThis.Object.defineProperty(message, MESSAGE_TYPE, { enumerable: false, value: this });
     if (value !== undefined) reflectionMergePartial<Player>(this, message, value);
     return message;
@@ -430,6 +454,15 @@ class Player$Type extends MessageType<Player> {
         case /* string name */ 3:
           message.name = reader.string();
           break;
+        case /* repeated int32 cpus */ 4:
+          if (wireType === WireType.LengthDelimited)
+            for (let e = reader.int32() + reader.pos; reader.pos < e; )
+              message.cpus.push(reader.int32());
+          else message.cpus.push(reader.int32());
+          break;
+        case /* optional bool suspended_when_idle */ 5:
+          message.suspendedWhenIdle = reader.bool();
+          break;
         default:
           let u = options.readUnknownField;
           if (u === "throw")
@@ -460,6 +493,15 @@ class Player$Type extends MessageType<Player> {
     if (message.index !== 0) writer.tag(2, WireType.Varint).int32(message.index);
     /* string name = 3; */
     if (message.name !== "") writer.tag(3, WireType.LengthDelimited).string(message.name);
+    /* repeated int32 cpus = 4; */
+    if (message.cpus.length) {
+      writer.tag(4, WireType.LengthDelimited).fork();
+      for (let i = 0; i < message.cpus.length; i++) writer.int32(message.cpus[i]);
+      writer.join();
+    }
+    /* optional bool suspended_when_idle = 5; */
+    if (message.suspendedWhenIdle !== undefined)
+      writer.tag(5, WireType.Varint).bool(message.suspendedWhenIdle);
     let u = options.writeUnknownFields;
     if (u !== false) (u == true ? UnknownFieldHandler.onWrite : u)(this.typeName, message, writer);
     return writer;
@@ -494,6 +536,7 @@ class Tick$Type extends MessageType<Tick> {
       { no: 7, name: "place", kind: "message", oneof: "action", T: () => PlaceAction },
       { no: 8, name: "stuck", kind: "scalar", oneof: "action", T: 8 /*ScalarType.BOOL*/ },
       { no: 9, name: "bots", kind: "message", repeat: 1 /*RepeatType.PACKED*/, T: () => Bot },
+      { no: 10, name: "race_winner", kind: "scalar", opt: true, T: 5 /*ScalarType.INT32*/ },
     ]);
   }
   create(value?: PartialMessage<Tick>): Tick {
@@ -572,6 +615,9 @@ class Tick$Type extends MessageType<Tick> {
         case /* repeated Bot bots */ 9:
           message.bots.push(Bot.internalBinaryRead(reader, reader.uint32(), options));
           break;
+        case /* optional int32 race_winner */ 10:
+          message.raceWinner = reader.int32();
+          break;
         default:
           let u = options.readUnknownField;
           if (u === "throw")
@@ -645,6 +691,8 @@ class Tick$Type extends MessageType<Tick> {
         writer.tag(9, WireType.LengthDelimited).fork(),
         options,
       ).join();
+    /* optional int32 race_winner = 10; */
+    if (message.raceWinner !== undefined) writer.tag(10, WireType.Varint).int32(message.raceWinner);
     let u = options.writeUnknownFields;
     if (u !== false) (u == true ? UnknownFieldHandler.onWrite : u)(this.typeName, message, writer);
     return writer;
@@ -14,16 +14,25 @@ import { botsTwo, initStateTwo } from "./initStates";
 import { decodeJson } from "./codec";
 import { matchConfigCodec } from "./common";
 import * as t from "io-ts";
-import { notNull } from "./utils";
 import { Match, Tick } from "./protobuf/match_log";
+import { decidedRace } from "./race";
+import { Board, Side } from "./board";
 
 type Action = Tick["action"];
 
 const BOT_LOG__MAX_LENGTH = 2000;
 
+const OPPOSITE_SIDE: Record<Side, Side> = {
+  top: "bottom",
+  right: "left",
+  bottom: "top",
+  left: "right",
+};
+
 const scores = new Map<string, number>();
 const tickLog: Tick[] = [];
 let botCommLog: TickCommLog[] = [];
+let stopDecidedGames = false;
 
 function resetBotCommLog(length: number) {
   botCommLog = [];
@@ -41,6 +50,7 @@ function mapToGameState(map: t.TypeOf<typeof quoridorMapCodec>): GameState {
       pawnPos: map.pawnPos,
       walls: [],
       ownedWalls: new Array(map.playerCount).fill(map.ownedWalls),
+      board: new Board(map.boardSize),
       // First index is x, second is y
       wallsByCell: Array.from({ length: map.boardSize }, (_, x) =>
         Object(
@@ -77,7 +87,8 @@ if (process.argv.length < 3) {
     fs.readFileSync(process.argv[2], { encoding: "utf-8" }),
   );
   const map = decodeJson(quoridorMapCodec, fs.readFileSync(matchConfig.map, { encoding: "utf-8" }));
-  const bots = new BotPool(matchConfig.bots);
+  const bots = new BotPool(matchConfig.bots, matchConfig.suspendIdleBots ?? false);
+  stopDecidedGames = matchConfig.stopDecidedGames ?? false;
   makeMatch(bots, mapToGameState(map)).catch((error) => {
     console.error(error);
     process.exit(1);
@@ -91,7 +102,9 @@ async function makeMatch(botPool: BotPool, state: GameState) {
     scores.set(bot.id, 0);
     const sendingData = startingPosToString(state, i);
     await sendMessage(bot, sendingData);
+    if (bot.cpus.length) console.log(`Bot ${bot.name} (index: #${i}) runs on CPUs ${bot.cpus}`);
   }
+  botPool.pauseAll();
 
   tickToVisualizer(botPool, state, [{ oneofKind: "start", start: true }]); // Save init state for visualizer
   while (!getEndStatus(botPool, state)) {
@@ -182,6 +195,7 @@ function updateState(state: GameState, userSteps: Action[]): GameState {
 
 /*
   Checks if some has reached the opposite side (Note: there are always at least two players alive, so we don't have to check that one)
+  If stopDecidedGames is set, a race that one of the players wins by force also ends the match.
   It also updates the scores.
 */
 function getEndStatus(botPool: BotPool, state: GameState): boolean {
@@ -200,6 +214,19 @@ function getEndStatus(botPool: BotPool, state: GameState): boolean {
     }
     return true;
   }
+  if (stopDecidedGames) {
+    const race = decidedRace(state, nextPlayer(state));
+    // The game only counts as decided if the winner gets to their goal before maxTicks
+    if (race !== null && state.tick.id + race.plies <= state.maxTicks) {
+      console.log(`${formatTime()}: player ${race.winner} wins the race in ${race.plies} ticks`);
+      for (let i = 0; i < state.numOfPlayers; i++) {
+        scores.set(botPool.bots[i].id, i === race.winner ? 1 : 0);
+      }
+      // The final distances may still be tied, so the log tells the tools who won
+      tickLog[tickLog.length - 1].raceWinner = race.winner;
+      return true;
+    }
+  }
   return false;
 }
 
@@ -259,6 +286,7 @@ function currentPlayerOutOfGame(state: GameState) {
 
 function placeWall(state: GameState, wall: WallPos) {
   updateWallsByCell(state.tick.wallsByCell, wall);
+  state.tick.board.placeWall(wall);
   state.tick.ownedWalls[state.tick.currentPlayer]--;
   state.tick.walls.push({ ...wall, who: state.tick.currentPlayer });
 }
@@ -419,73 +447,16 @@ function wallIsValid(state: GameState, wall: Wall): { result: boolean; reason?:
     };
   }
 
-  const newWallsByCell = state.tick.wallsByCell.map((row) => row.map((cell) => ({ ...cell })));
-  updateWallsByCell(newWallsByCell, wall);
   // Does the new wall cut off the only remaining path of a pawn to the side of the board it must reach?
-  // Check it with BFS for all players.
-  if (
-    state.tick.pawnPos[0].x >= 0 &&
-    bfsForPlayers(
-      state.boardSize,
-      newWallsByCell,
-      state.tick.pawnPos[0].x,
-      state.tick.pawnPos[0].y,
-      (x, y) => y === state.boardSize - 1,
-    ) === -1
-  ) {
-    return {
-      result: false,
-      reason:
-        "The new wall cuts off the the only remaining path of pawn starting from top reaching the bottom side.",
-    };
-  }
-  if (
-    state.tick.pawnPos[1].x >= 0 &&
-    bfsForPlayers(
-      state.boardSize,
-      newWallsByCell,
-      state.tick.pawnPos[1].x,
-      state.tick.pawnPos[1].y,
-      (x, y) => (state.numOfPlayers === 4 ? x === 0 : y === 0),
-    ) === -1
-  ) {
-    return {
-      result: false,
-      reason:
-        "The new wall cuts off the the only remaining path of pawn starting from right reaching the left side.",
-    };
-  }
-  if (state.numOfPlayers === 4) {
-    if (
-      state.tick.pawnPos[2].x >= 0 &&
-      bfsForPlayers(
-        state.boardSize,
-        newWallsByCell,
-        state.tick.pawnPos[2].x,
-        state.tick.pawnPos[2].y,
-        (x, y) => y === 0,
-      ) === -1
-    ) {
+  for (let player = 0; player < state.numOfPlayers; player++) {
+    const pawn = state.tick.pawnPos[player];
+    const goal = goalSide(state, player);
+    if (pawn.x >= 0 && state.tick.board.wallCutsOff(pawn.x, pawn.y, goal, wall)) {
       return {
         result: false,
         reason:
-          "The new wall cuts off the the only remaining path of pawn starting from bottom reaching the top side.",
-      };
-    }
-    if (
-      state.tick.pawnPos[3].x >= 0 &&
-      bfsForPlayers(
-        state.boardSize,
-        newWallsByCell,
-        state.tick.pawnPos[3].x,
-        state.tick.pawnPos[3].y,
-        (x, y) => x === state.boardSize - 1,
-      ) === -1
-    ) {
-      return {
-        result: false,
-        reason:
-          "The new wall cuts off the the only remaining path of pawn starting from left reaching the right side.",
+          "The new wall cuts off the only remaining path of pawn " +
+          `starting from ${OPPOSITE_SIDE[goal]} reaching the ${goal} side.`,
       };
     }
   }
@@ -494,98 +465,22 @@ function wallIsValid(state: GameState, wall: Wall): { result: boolean; reason?:
 }
 
 /*
-  Calculates the length of the shortest path from the player to the goal. If there is no path, it returns -1.
+  The side of the board the player has to reach.
 */
-function bfsForPlayers(
-  boardSize: number,
-  wallsByCell: WallsByCell,
-  starting_x: number,
-  starting_y: number,
-  goalReached: (x: number, y: number) => boolean,
-): number {
-  if (starting_x < 0) return -1;
-  const visited = Array(boardSize)
-    .fill(0)
-    .map(() => new Array(boardSize).fill(false));
-  let currentQueue = new Array<[number, number]>();
-  let nextQueue = new Array<[number, number]>();
-  currentQueue.push([starting_x, starting_y]);
-  visited[starting_x][starting_y] = true;
-  let depth = 0;
-  const maxDepth = boardSize * boardSize;
-
-  while (currentQueue.length > 0) {
-    if (depth > maxDepth) {
-      throw new Error("Internal Game Server Error! Max depth is reached in BFS.");
-    }
-
-    while (currentQueue.length > 0) {
-      const [x, y] = notNull(currentQueue.shift());
-      // Check if we reached our goal
-      if (goalReached(x, y)) {
-        return depth;
-      }
-      // Check if we can move to the left
-      if (!wallsByCell[x][y].left && !visited[x - 1][y]) {
-        nextQueue.push([x - 1, y]);
-        visited[x - 1][y] = true;
-      }
-      // Check if we can move to the right
-      if (!wallsByCell[x][y].right && !visited[x + 1][y]) {
-        nextQueue.push([x + 1, y]);
-        visited[x + 1][y] = true;
-      }
-      // Check if we can move to the top
-      if (!wallsByCell[x][y].top && !visited[x][y - 1]) {
-        nextQueue.push([x, y - 1]);
-        visited[x][y - 1] = true;
-      }
-      // Check if we can move to the bottom
-      if (!wallsByCell[x][y].bottom && !visited[x][y + 1]) {
-        nextQueue.push([x, y + 1]);
-        visited[x][y + 1] = true;
-      }
-    }
-    depth++;
-    currentQueue = nextQueue;
-    nextQueue = new Array<[number, number]>();
+function goalSide(state: GameState, player: PlayerID): Side {
+  if (state.numOfPlayers === 4) {
+    return (["bottom", "left", "top", "right"] as const)[player];
   }
-  return -1;
+  return player === 0 ? "bottom" : "top";
 }
 
+/*
+  Calculates the length of the shortest path from each player to their goal, -1 for the players out of the game.
+*/
 function getPlayersDistanceFromGoal(state: GameState): number[] {
-  const distances = new Array<number>(state.numOfPlayers);
-  distances[0] = bfsForPlayers(
-    state.boardSize,
-    state.tick.wallsByCell,
-    state.tick.pawnPos[0].x,
-    state.tick.pawnPos[0].y,
-    (x, y) => y === state.boardSize - 1,
+  return state.tick.pawnPos.map((pawn, player) =>
+    state.tick.board.distance(pawn.x, pawn.y, goalSide(state, player)),
   );
-  distances[1] = bfsForPlayers(
-    state.boardSize,
-    state.tick.wallsByCell,
-    state.tick.pawnPos[1].x,
-    state.tick.pawnPos[1].y,
-    (x, y) => (state.numOfPlayers === 4 ? x === 0 : y === 0),
-  );
-  if (state.numOfPlayers === 4) {
-    distances[2] = bfsForPlayers(
-      state.boardSize,
-      state.tick.wallsByCell,
-      state.tick.pawnPos[2].x,
-      state.tick.pawnPos[2].y,
-      (x, y) => y === 0,
-    );
-    distances[3] = bfsForPlayers(
-      state.boardSize,
-      state.tick.wallsByCell,
-      state.tick.pawnPos[3].x,
-      state.tick.pawnPos[3].y,
-      (x, y) => x === state.boardSize - 1,
-    );
-  }
-  return distances;
 }
 
 function getPlayerByCell(state: GameState, x: number, y: number): number | null {
@@ -651,6 +546,8 @@ function stateToVisualizer(botPool: BotPool, state: GameState): void {
         id: bot.id,
         index: bot.index,
         name: bot.name,
+        cpus: bot.cpus,
+        suspendedWhenIdle: bot.suspendWhenIdle || undefined,
       })),
       boardSize: state.boardSize,
       numOfWalls: state.tick.ownedWalls.reduce((a, b) => a + b, 0),
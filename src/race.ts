@@ -0,0 +1,235 @@
+import { GameState, PawnPos, PlayerID, WallsByCell } from "./types";
+
+export const WIN = 1;
+export const UNDECIDED = 0;
+export const LOSS = -1;
+
+// up, right, down, left
+const DX = [0, 1, 0, -1];
+const DY = [-1, 0, 1, 0];
+
+/*
+  Exact solution of the race at the end of a two player game, when no player has walls left.
+  The same algorithm as public/quoridor_race.h: with the walls fixed, every placement of the two
+  pawns is solved by retrograde analysis, walking back from the finished positions along the legal
+  moves (jumps included). Player 0 goes for the bottom row, player 1 for the top row.
+*/
+export class RaceTable {
+  private readonly blocked: Uint8Array;
+  private readonly distance: Int32Array[] = [];
+  private readonly cellIndex: Int32Array[] = [];
+  private readonly cells: number[][] = [];
+  private readonly result: Int8Array;
+  private readonly plies: Int16Array;
+  private readonly moves = new Int32Array(8);
+
+  public constructor(private readonly boardSize: number, wallsByCell: WallsByCell) {
+    const m = boardSize;
+    this.blocked = new Uint8Array(m * m * 4);
+    for (let x = 0; x < m; x++) {
+      for (let y = 0; y < m; y++) {
+        const cell = y * m + x;
+        const borders = wallsByCell[x][y];
+        this.blocked[cell * 4] = borders.top ? 1 : 0;
+        this.blocked[cell * 4 + 1] = borders.right ? 1 : 0;
+        this.blocked[cell * 4 + 2] = borders.bottom ? 1 : 0;
+        this.blocked[cell * 4 + 3] = borders.left ? 1 : 0;
+      }
+    }
+    this.distanceField(0, (cell) => Math.floor(cell / m) === m - 1);
+    this.distanceField(1, (cell) => Math.floor(cell / m) === 0);
+    const numStates = this.cells[0].length * this.cells[1].length * 2;
+    this.result = new Int8Array(numStates);
+    this.plies = new Int16Array(numStates);
+    this.solve();
+  }
+
+  /*
+    Result for the player to move (WIN, LOSS or UNDECIDED) and the number of plies until the end.
+  */
+  public value(
+    pawn0: PawnPos,
+    pawn1: PawnPos,
+    toMove: PlayerID,
+  ): { result: number; plies: number } {
+    const m = this.boardSize;
+    const s = this.stateIndex(pawn0.y * m + pawn0.x, pawn1.y * m + pawn1.x, toMove);
+    if (s < 0) return { result: UNDECIDED, plies: 0 };
+    return { result: this.result[s], plies: this.plies[s] };
+  }
+
+  private open(cell: number, direction: number): boolean {
+    return this.blocked[cell * 4 + direction] === 0;
+  }
+
+  private neighbor(cell: number, direction: number): number {
+    return cell + DY[direction] * this.boardSize + DX[direction];
+  }
+
+  private distanceField(side: number, isGoal: (cell: number) => boolean) {
+    const numCells = this.boardSize * this.boardSize;
+    const field = new Int32Array(numCells).fill(-1);
+    const queue = new Int32Array(numCells);
+    let queueEnd = 0;
+    for (let cell = 0; cell < numCells; cell++) {
+      if (isGoal(cell)) {
+        field[cell] = 0;
+        queue[queueEnd++] = cell;
+      }
+    }
+    for (let i = 0; i < queueEnd; i++) {
+      for (let direction = 0; direction < 4; direction++) {
+        if (!this.open(queue[i], direction)) continue;
+        const next = this.neighbor(queue[i], direction);
+        if (field[next] < 0) {
+          field[next] = field[queue[i]] + 1;
+          queue[queueEnd++] = next;
+        }
+      }
+    }
+    const index = new Int32Array(numCells).fill(-1);
+    const cells: number[] = [];
+    for (let cell = 0; cell < numCells; cell++) {
+      if (field[cell] >= 0) {
+        index[cell] = cells.length;
+        cells.push(cell);
+      }
+    }
+    this.distance[side] = field;
+    this.cellIndex[side] = index;
+    this.cells[side] = cells;
+  }
+
+  /*
+    Same rules as possibleMoves in quoridor.ts, for two pawns. Fills this.moves, returns the count.
+  */
+  private legalMoves(from: number, other: number): number {
+    let count = 0;
+    for (let direction = 0; direction < 4; direction++) {
+      if (!this.open(from, direction)) continue;
+      const next = this.neighbor(from, direction);
+      if (next !== other) {
+        this.moves[count++] = next;
+      } else if (this.open(next, direction)) {
+        this.moves[count++] = this.neighbor(next, direction);
+      } else {
+        for (const side of [(direction + 1) % 4, (direction + 3) % 4]) {
+          if (this.open(next, side)) this.moves[count++] = this.neighbor(next, side);
+        }
+      }
+    }
+    return count;
+  }
+
+  private canMove(from: number, other: number, to: number): boolean {
+    const count = this.legalMoves(from, other);
+    for (let i = 0; i < count; i++) {
+      if (this.moves[i] === to) return true;
+    }
+    return false;
+  }
+
+  private stateIndex(cell0: number, cell1: number, toMove: number): number {
+    const index0 = this.cellIndex[0][cell0];
+    const index1 = this.cellIndex[1][cell1];
+    if (cell0 === cell1 || index0 < 0 || index1 < 0) return -1;
+    return (index0 * this.cells[1].length + index1) * 2 + toMove;
+  }
+
+  private solve() {
+    const m = this.boardSize;
+    const remaining = new Uint8Array(this.result.length);
+    const queue = new Int32Array(this.result.length);
+    let queueEnd = 0;
+    for (const cell0 of this.cells[0]) {
+      for (const cell1 of this.cells[1]) {
+        if (cell0 === cell1) continue;
+        const cell = [cell0, cell1];
+        for (let toMove = 0; toMove < 2; toMove++) {
+          const s = this.stateIndex(cell0, cell1, toMove);
+          if (this.distance[1 - toMove][cell[1 - toMove]] === 0) {
+            this.result[s] = LOSS;
+            queue[queueEnd++] = s;
+          } else if (this.distance[toMove][cell[toMove]] === 0) {
+            this.result[s] = WIN;
+            queue[queueEnd++] = s;
+          } else {
+            remaining[s] = this.legalMoves(cell[toMove], cell[1 - toMove]);
+          }
+        }
+      }
+    }
+
+    // The queue is ordered by plies: a win is found by its shortest line, a loss by its longest one
+    const count1 = this.cells[1].length;
+    for (let i = 0; i < queueEnd; i++) {
+      const s = queue[i];
+      const toMove = s % 2;
+      const pairIndex = Math.floor(s / 2);
+      const cell = [
+        this.cells[0][Math.floor(pairIndex / count1)],
+        this.cells[1][pairIndex % count1],
+      ];
+      // The player who moved into this position
+      const mover = 1 - toMove;
+      const target = cell[mover];
+      const other = cell[toMove];
+      if (this.distance[toMove][other] === 0) continue;
+      for (let dy = -2; dy <= 2; dy++) {
+        for (let dx = -2 + Math.abs(dy); dx <= 2 - Math.abs(dy); dx++) {
+          const x = (target % m) + dx;
+          const y = Math.floor(target / m) + dy;
+          if ((dx === 0 && dy === 0) || x < 0 || x >= m || y < 0 || y >= m) continue;
+          const from = y * m + x;
+          if (from === other || this.distance[mover][from] <= 0) continue;
+          if (!this.canMove(from, other, target)) continue;
+          const predecessor =
+            mover === 0 ? this.stateIndex(from, other, 0) : this.stateIndex(other, from, 1);
+          if (this.result[predecessor] !== UNDECIDED) continue;
+          if (this.result[s] === LOSS) {
+            this.result[predecessor] = WIN;
+            this.plies[predecessor] = this.plies[s] + 1;
+            queue[queueEnd++] = predecessor;
+          } else if (--remaining[predecessor] === 0) {
+            this.result[predecessor] = LOSS;
+            this.plies[predecessor] = this.plies[s] + 1;
+            queue[queueEnd++] = predecessor;
+          }
+        }
+      }
+    }
+  }
+}
+
+export function isRace(state: GameState): boolean {
+  return state.numOfPlayers === 2 && state.tick.ownedWalls.every((walls) => walls === 0);
+}
+
+// The walls cannot change during a race, so one table serves the rest of the match
+let cachedTable: { boardSize: number; walls: number; table: RaceTable } | null = null;
+
+/*
+  If the game is a race that one of the players can force, returns the winner and the number of
+  ticks until they reach their goal. Otherwise returns null.
+*/
+export function decidedRace(
+  state: GameState,
+  playerToMove: PlayerID,
+): { winner: PlayerID; plies: number } | null {
+  if (!isRace(state)) return null;
+  if (
+    cachedTable === null ||
+    cachedTable.boardSize !== state.boardSize ||
+    cachedTable.walls !== state.tick.walls.length
+  ) {
+    cachedTable = {
+      boardSize: state.boardSize,
+      walls: state.tick.walls.length,
+      table: new RaceTable(state.boardSize, state.tick.wallsByCell),
+    };
+  }
+  const [pawn0, pawn1] = state.tick.pawnPos;
+  const { result, plies } = cachedTable.table.value(pawn0, pawn1, playerToMove);
+  if (result === UNDECIDED) return null;
+  return { winner: result === WIN ? playerToMove : 1 - playerToMove, plies };
+}
@@ -0,0 +1,114 @@
+/*
+  Ratings of the bots of a tournament, updated one match at a time as the results come in.
+
+  Elo is the usual logistic model with a fixed K factor. Glicko (Glickman's original system) also
+  keeps a rating deviation per bot, so a bot that played few matches moves faster and its rating
+  comes with an error bar. Every match is its own rating period and the deviation does not grow
+  back between them, as a tournament is far too short for the bots' strength to drift.
+*/
+
+const ELO_START = 1500;
+const ELO_K = 16;
+
+const GLICKO_START = 1500;
+const GLICKO_START_RD = 350;
+// Keeps the ratings moving late in a long tournament
+const GLICKO_MIN_RD = 30;
+const Q = Math.log(10) / 400;
+
+export interface Rating {
+  id: string;
+  name: string;
+  games: number;
+  wins: number;
+  draws: number;
+  losses: number;
+  // Sum of the match scores passed to `record`: 1 for a win, 0.5 for a draw, the bot's share of
+  // the score.json points in general
+  points: number;
+  elo: number;
+  glicko: number;
+  glickoRd: number;
+}
+
+function glickoG(rd: number): number {
+  return 1 / Math.sqrt(1 + (3 * Q * Q * rd * rd) / (Math.PI * Math.PI));
+}
+
+function glickoUpdate(
+  player: { rating: number; rd: number },
+  opponent: { rating: number; rd: number },
+  score: number,
+): { rating: number; rd: number } {
+  const g = glickoG(opponent.rd);
+  const expected = 1 / (1 + Math.pow(10, (-g * (player.rating - opponent.rating)) / 400));
+  const dSquaredInverse = Q * Q * g * g * expected * (1 - expected);
+  const precision = 1 / (player.rd * player.rd) + dSquaredInverse;
+  return {
+    rating: player.rating + (Q / precision) * g * (score - expected),
+    rd: Math.max(GLICKO_MIN_RD, Math.sqrt(1 / precision)),
+  };
+}
+
+export class Ratings {
+  private readonly ratings = new Map<string, Rating>();
+
+  public constructor(bots: { id: string; name: string }[]) {
+    for (const { id, name } of bots) {
+      this.ratings.set(id, {
+        id,
+        name,
+        games: 0,
+        wins: 0,
+        draws: 0,
+        losses: 0,
+        points: 0,
+        elo: ELO_START,
+        glicko: GLICKO_START,
+        glickoRd: GLICKO_START_RD,
+      });
+    }
+  }
+
+  /*
+    Records a two player match. `scoreA` is the score of bot A: 1 for a win, 0 for a loss, 0.5 for
+    a draw. Matches of bots that are not in the tournament are ignored.
+  */
+  public record(idA: string, idB: string, scoreA: number) {
+    const a = this.ratings.get(idA);
+    const b = this.ratings.get(idB);
+    if (!a || !b) return;
+
+    const expectedA = 1 / (1 + Math.pow(10, (b.elo - a.elo) / 400));
+    const eloChange = ELO_K * (scoreA - expectedA);
+    a.elo += eloChange;
+    b.elo -= eloChange;
+
+    const beforeA = { rating: a.glicko, rd: a.glickoRd };
+    const beforeB = { rating: b.glicko, rd: b.glickoRd };
+    const glickoA = glickoUpdate(beforeA, beforeB, scoreA);
+    const glickoB = glickoUpdate(beforeB, beforeA, 1 - scoreA);
+    a.glicko = glickoA.rating;
+    a.glickoRd = glickoA.rd;
+    b.glicko = glickoB.rating;
+    b.glickoRd = glickoB.rd;
+
+    for (const [rating, score] of [
+      [a, scoreA],
+      [b, 1 - scoreA],
+    ] as const) {
+      rating.games++;
+      rating.points += score;
+      if (score > 0.5) rating.wins++;
+      else if (score < 0.5) rating.losses++;
+      else rating.draws++;
+    }
+  }
+
+  // Best first, by the lower end of the Glicko interval so a lucky newcomer does not lead
+  public standings(): Rating[] {
+    return [...this.ratings.values()].sort(
+      (a, b) => b.glicko - 2 * b.glickoRd - (a.glicko - 2 * a.glickoRd) || b.elo - a.elo,
+    );
+  }
+}
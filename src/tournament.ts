@@ -0,0 +1,306 @@
+import { Bot } from "./BotWrapper";
+import { spawn } from "child_process";
+import * as fs from "fs";
+import * as os from "os";
+import * as path from "path";
+import { BotConfig, TournamentConfig, tournamentConfigCodec } from "./common";
+import { decodeJson } from "./codec";
+import { Job, JobQueue, JobResult } from "./jobQueue";
+import { Rating, Ratings } from "./rating";
+import { quoridorMapCodec } from "./types";
+import { notNull } from "./utils";
+
+/*
+  Round-robin tournament of bots, played by a pool of workers.
+
+    node dist/tournament.js tournament.json            coordinator, with `workers` local workers
+    node dist/tournament.js tournament.json --worker   more workers, e.g. on another machine
+
+  The coordinator puts every match into the job queue (src/jobQueue.ts), plays them with its own
+  workers and updates the ratings (src/rating.ts) as the results come in. The standings are kept
+  in standings.json in the queue directory. Starting the coordinator again with the same config
+  continues an interrupted tournament: finished matches are not played again, failed ones are.
+  Bots or rounds added to the config are played in addition to the finished matches.
+
+  Workers exit once the coordinator found every result, so start them after the coordinator.
+  They read the same config as the coordinator, only `queueDir` and the worker settings are used.
+
+  Each match is a run of quoridor.js in its own directory, so a crashing match server only loses
+  that match.
+*/
+
+const DEFAULT_MAPS = ["maps/2-players-default.json", "maps/2-players-reversed.json"];
+const POLL_INTERVAL = 1000; // in ms
+const HEARTBEAT_INTERVAL = 5000; // in ms
+// A running job not touched for this long is given to another worker
+const LEASE_TIMEOUT = 60000; // in ms
+// A match may take this many times the bots' time budget, plus the slack for starting up
+const MATCH_TIME_FACTOR = 2;
+const MATCH_TIME_SLACK = 30000; // in ms
+
+// Match servers run in process groups of their own, so they can be killed together with their bots
+const runningServers = new Set<number>();
+
+function killServer(pid: number) {
+  try {
+    process.kill(-pid, "SIGKILL");
+  } catch {
+    // Already gone
+  }
+}
+
+for (const signal of ["SIGINT", "SIGTERM"] as const) {
+  process.on(signal, () => {
+    for (const pid of runningServers) killServer(pid);
+    process.exit(1);
+  });
+}
+
+const delay = (ms: number) => new Promise((resolve) => setTimeout(resolve, ms));
+
+function timestamp(): string {
+  return new Date().toLocaleTimeString();
+}
+
+// Job ids are file names in the queue
+function safeName(name: string): string {
+  return name.replace(/[^A-Za-z0-9_-]/g, "_");
+}
+
+/*
+  Paths in the config are relative to the config file. Workers on other machines get the jobs
+  with absolute paths, so the bots and maps have to be at the same place on every machine.
+*/
+function resolveCommand(command: string, baseDir: string): string {
+  return command.includes("/") ? path.resolve(baseDir, command) : command;
+}
+
+function makeJobs(config: TournamentConfig, baseDir: string): Job[] {
+  const maps = (config.maps ?? DEFAULT_MAPS).map((map) => path.resolve(baseDir, map));
+  const timeLimits = new Map<string, number>();
+  for (const map of maps) {
+    const { playerCount, maxTicks } = decodeJson(quoridorMapCodec, fs.readFileSync(map, "utf-8"));
+    if (playerCount !== 2) throw new Error(`${map}: tournaments are played on two player maps`);
+    const budget = Bot.matchTimeBudget(playerCount, maxTicks);
+    timeLimits.set(map, MATCH_TIME_FACTOR * budget + MATCH_TIME_SLACK);
+  }
+  const bots: BotConfig[] = config.bots.map((bot) => ({
+    ...bot,
+    runCommand: resolveCommand(bot.runCommand, baseDir),
+  }));
+
+  const jobs = new Map<string, Job>();
+  for (let round = 0; round < (config.rounds ?? 1); round++) {
+    for (const map of maps) {
+      for (const first of bots) {
+        for (const second of bots) {
+          if (first === second) continue;
+          const id = [round, path.basename(map, ".json"), first.id, second.id].map(String);
+          const job = {
+            id: id.map(safeName).join("."),
+            map,
+            bots: [first, second],
+            timeLimit: notNull(timeLimits.get(map)),
+          };
+          if (jobs.has(job.id)) throw new Error(`Job id ${job.id} is not unique, rename the bots`);
+          jobs.set(job.id, job);
+        }
+      }
+    }
+  }
+  return [...jobs.values()];
+}
+
+// Runs quoridor.js for the job in its match directory and reads its score.json
+function playMatch(
+  queue: JobQueue,
+  job: Job,
+  worker: string,
+  config: TournamentConfig,
+  cpus: number[][] | null,
+): Promise<JobResult> {
+  const dir = queue.matchDir(job.id);
+  fs.rmSync(dir, { recursive: true, force: true });
+  fs.mkdirSync(dir, { recursive: true });
+  const matchConfig = {
+    map: job.map,
+    bots: job.bots.map((bot, i) => (cpus ? { ...bot, cpus: cpus[i] } : bot)),
+    stopDecidedGames: config.stopDecidedGames,
+    suspendIdleBots: config.suspendIdleBots,
+  };
+  fs.writeFileSync(path.join(dir, "config.json"), JSON.stringify(matchConfig, undefined, 2));
+  const output = fs.openSync(path.join(dir, "server.log"), "w");
+
+  return new Promise((resolve) => {
+    const server = spawn(process.execPath, [path.join(__dirname, "quoridor.js"), "config.json"], {
+      cwd: dir,
+      stdio: ["ignore", output, output],
+      detached: true,
+    });
+    const pid = server.pid;
+    if (pid !== undefined) runningServers.add(pid);
+    // A bot that ignores SIGTERM can keep the server from ever exiting
+    const timer = setTimeout(() => {
+      finish(`match took longer than ${job.timeLimit / 1000} s`);
+      if (pid !== undefined) killServer(pid);
+    }, job.timeLimit);
+    let finished = false;
+    const finish = (error?: string) => {
+      // A process that failed to start may report both an error and an exit, a killed one its exit
+      if (finished) return;
+      finished = true;
+      clearTimeout(timer);
+      if (pid !== undefined) runningServers.delete(pid);
+      fs.closeSync(output);
+      const scoreFile = path.join(dir, "score.json");
+      const scores =
+        !error && fs.existsSync(scoreFile) ? JSON.parse(fs.readFileSync(scoreFile, "utf-8")) : null;
+      resolve({
+        id: job.id,
+        scores,
+        error: scores ? undefined : error ?? "no score.json",
+        worker,
+        finishedAt: new Date().toISOString(),
+      });
+    };
+    server.on("error", (error) => finish("server error: " + error.message));
+    server.on("exit", (code, signal) =>
+      finish(code === 0 ? undefined : `server exited with ${signal ?? `code ${code}`}`),
+    );
+  });
+}
+
+// Plays jobs until the coordinator marks the queue finished
+async function runWorker(
+  queue: JobQueue,
+  worker: string,
+  config: TournamentConfig,
+  cpus: number[][] | null,
+) {
+  for (;;) {
+    const job = queue.claim();
+    if (!job) {
+      if (queue.isFinished()) return;
+      await delay(POLL_INTERVAL);
+      continue;
+    }
+    const heartbeat = setInterval(() => queue.heartbeat(job.id), HEARTBEAT_INTERVAL);
+    try {
+      queue.complete(await playMatch(queue, job, worker, config, cpus));
+    } finally {
+      clearInterval(heartbeat);
+    }
+  }
+}
+
+// Starts the local workers, the bots of worker w get CPUs 2w and 2w + 1 when pinned
+function startWorkers(queue: JobQueue, config: TournamentConfig): Promise<void>[] {
+  const numCpus = os.cpus().length;
+  const count = config.workers ?? Math.max(1, Math.floor(numCpus / 2));
+  return Array.from({ length: count }, (_, w) => {
+    const cpus = config.pinCpus ? [[(2 * w) % numCpus], [(2 * w + 1) % numCpus]] : null;
+    return runWorker(queue, `${os.hostname()}:${process.pid}:${w}`, config, cpus);
+  });
+}
+
+function formatStandings(standings: Rating[]): string {
+  const row = (columns: string[]) =>
+    [
+      columns[0].padStart(4),
+      columns[1].padEnd(24),
+      columns[2].padStart(6),
+      columns[3].padEnd(5),
+      columns[4].padStart(6),
+      columns[5].padStart(12),
+      columns[6].padStart(8),
+    ].join(" ");
+  const rows = standings.map((rating, place) =>
+    row([
+      `${place + 1}.`,
+      rating.name,
+      rating.glicko.toFixed(0),
+      `±${(2 * rating.glickoRd).toFixed(0)}`,
+      rating.elo.toFixed(0),
+      `${rating.wins}/${rating.draws}/${rating.losses}`,
+      rating.points.toFixed(1),
+    ]),
+  );
+  return [row(["", "bot", "glicko", "", "elo", "w/d/l", "points"]), ...rows].join("\n");
+}
+
+async function runTournament(config: TournamentConfig, baseDir: string, queue: JobQueue) {
+  const jobs = makeJobs(config, baseDir);
+  const jobsById = new Map(jobs.map((job) => [job.id, job]));
+  queue.reopen();
+  queue.prune(new Set(jobsById.keys()));
+  queue.dropFailed();
+  for (const job of jobs) queue.add(job);
+
+  const ratings = new Ratings(config.bots);
+  const seen = new Set<string>();
+  let failed = 0;
+  // Results of an earlier run are replayed quietly, in the order they were played
+  const collect = (quiet: boolean) => {
+    const fresh = queue
+      .finishedIds()
+      .filter((id) => jobsById.has(id) && !seen.has(id))
+      .map((id) => queue.result(id))
+      .filter((result): result is JobResult => result !== null)
+      .sort((a, b) => a.finishedAt.localeCompare(b.finishedAt) || a.id.localeCompare(b.id));
+    for (const result of fresh) {
+      seen.add(result.id);
+      const [first, second] = notNull(jobsById.get(result.id)).bots;
+      if (result.scores === null) {
+        failed++;
+        if (quiet) continue;
+        console.log(`${timestamp()} [${seen.size}/${jobs.length}] ${result.id}: ${result.error}`);
+        continue;
+      }
+      const score = result.scores[first.id] ?? 0;
+      const otherScore = result.scores[second.id] ?? 0;
+      // Both score 0 if the match ended without a winner, for example when both bots failed
+      const scoreFirst = score + otherScore > 0 ? score / (score + otherScore) : 0.5;
+      ratings.record(first.id, second.id, scoreFirst);
+      if (quiet) continue;
+      console.log(
+        `${timestamp()} [${seen.size}/${jobs.length}] ${first.name} - ${second.name}` +
+          ` ${scoreFirst}-${1 - scoreFirst} (${result.id})`,
+      );
+    }
+    if (fresh.length) {
+      queue.writeAtomic(path.join(queue.dir, "standings.json"), ratings.standings());
+    }
+  };
+
+  collect(true);
+  console.log(`${timestamp()} ${jobs.length - seen.size} of ${jobs.length} matches to play`);
+  const workers = startWorkers(queue, config);
+  while (seen.size < jobs.length) {
+    await delay(POLL_INTERVAL);
+    const requeued = queue.requeueStale(LEASE_TIMEOUT);
+    if (requeued) console.log(`${timestamp()} ${requeued} matches of lost workers requeued`);
+    collect(false);
+  }
+  queue.finish();
+  await Promise.all(workers);
+
+  console.log(formatStandings(ratings.standings()));
+  if (failed) console.log(`${failed} matches failed, run the tournament again to retry them`);
+}
+
+if (process.argv.length < 3) {
+  console.error("Usage: node tournament.js tournament.json [--worker]");
+  process.exit(1);
+} else {
+  const configPath = path.resolve(process.argv[2]);
+  const config = decodeJson(tournamentConfigCodec, fs.readFileSync(configPath, "utf-8"));
+  const baseDir = path.dirname(configPath);
+  const queue = new JobQueue(path.resolve(baseDir, config.queueDir ?? "tournament"));
+  const run = process.argv.includes("--worker")
+    ? Promise.all(startWorkers(queue, config))
+    : runTournament(config, baseDir, queue);
+  run.catch((error) => {
+    console.error(error);
+    process.exit(1);
+  });
+}
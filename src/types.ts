@@ -1,4 +1,5 @@
 import * as t from "io-ts";
+import { Board } from "./board";
 
 export type PlayerID = number;
 
@@ -36,6 +37,7 @@ export type Tick = {
   pawnPos: PawnPos[];
   walls: Wall[];
   wallsByCell: WallsByCell;
+  board: Board;
   ownedWalls: number[];
 };
 
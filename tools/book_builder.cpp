@@ -0,0 +1,318 @@
+/**
+ * Builds an opening book for public/quoridor_book.h from match logs and self-play games.
+ *
+ *     g++ -O2 -std=c++17 -pthread -o book_builder tools/book_builder.cpp
+ *     ./book_builder openings.book logs/ selfplay/ [-j threads] [--plies 20]
+ *
+ * `match.log` files in the directories, and files given by name other than `*.game`, are read as server
+ * match logs. `*.game` files are self-play records in the bots' own protocol, all coordinates global:
+ *
+ *     <board size> <players> <walls per player> <starting player>
+ *     <x> <y>                  starting pawn of each player, one line each
+ *     <x> <y> | <x> <y> <v>    one line per ply, the answer of the player to move
+ *     result <winner>          index of the winning player, -1 for a draw
+ *
+ * Only the first `--plies` moves of every game go into the book. Moves after which the server logged an
+ * error for the bot, or of a bot already offline, are dropped, as the server replaced them with a random step.
+ */
+#include <bits/stdc++.h>
+
+using namespace std;
+
+struct Pos {
+    int x, y;
+
+    /** Returns the new coordinates of this position after rotating the board counter clockwise by a number of quarter turns */
+    Pos rotate(int m, int quarters) const {
+        switch (quarters % 4) {
+            case 0:
+                return {x, y};
+            case 1:
+                return {y, m - 1 - x};
+            case 2:
+                return {m - 1 - x, m - 1 - y};
+            case 3:
+                return {m - 1 - y, x};
+        }
+        __builtin_unreachable();
+    }
+};
+
+struct Player {
+    int x, y;
+    int walls;
+};
+
+struct Wall {
+    int x, y;
+    bool is_vertical;
+
+    /** Returns the new representation of this wall after rotating the board counter clockwise by a number of quarter turns */
+    Wall rotate(int m, int quarters) const {
+        // The top-left corner of the original wall box. Which is not the top-left corner of the rotated box!
+        Pos rotated_corner = Pos{x, y}.rotate(m, quarters);
+        switch (quarters % 4) {
+            case 0:
+                return {x, y, is_vertical};
+            case 1:
+                return {rotated_corner.x, rotated_corner.y - 1, !is_vertical};
+            case 2:
+                return {rotated_corner.x - 1, rotated_corner.y - 1, is_vertical};
+            case 3:
+                return {rotated_corner.x - 1, rotated_corner.y, !is_vertical};
+        }
+        __builtin_unreachable();
+    }
+};
+
+#include "../public/quoridor_book.h"
+#include "match_log_reader.h"
+
+struct Sample {
+    uint64_t key;
+    uint16_t move;
+    uint8_t mover;
+    /** Score of the mover at the end of the game in `BOOK_SCORE_UNIT`ths, filled in once the game is over */
+    uint8_t points;
+};
+
+/** Replays one game in global coordinates and records the book samples of its first plies */
+class GameReplay {
+public:
+    explicit GameReplay(int max_plies) : max_plies(max_plies) {}
+
+    void start(int board_size, const vector<Player> &start_players) {
+        m = board_size;
+        n = start_players.size();
+        players = start_players;
+        walls.clear();
+        plies = 0;
+    }
+
+    /** Records the move of `mover` from the current position, then applies it */
+    void play(int mover, const BookMove &move, bool record = true) {
+        if (record && plies < max_plies && mover >= 0 && mover < n) {
+            int quarters = n == 2 ? 2 * mover : mover;
+            vector<Player> rotated_players(n);
+            transform(players.begin(), players.end(), rotated_players.begin(), [&](const Player &player) {
+                Pos rotated_pos = Pos{player.x, player.y}.rotate(m, quarters);
+                return Player{rotated_pos.x, rotated_pos.y, player.walls};
+            });
+            vector<Wall> rotated_walls(walls.size());
+            transform(walls.begin(), walls.end(), rotated_walls.begin(), [&](const Wall &wall) {
+                return wall.rotate(m, quarters);
+            });
+            BookKey key = book_key(m, n, mover, rotated_players, rotated_walls);
+            BookMove rotated_move;
+            if (move.is_wall) {
+                Wall wall = Wall{move.x, move.y, move.is_vertical}.rotate(m, quarters);
+                rotated_move = {true, wall.x, wall.y, wall.is_vertical};
+            } else {
+                Pos pos = Pos{move.x, move.y}.rotate(m, quarters);
+                rotated_move = {false, pos.x, pos.y, false};
+            }
+            if (key.mirrored)
+                rotated_move = rotated_move.mirror(m);
+            samples.push_back({key.key, rotated_move.encode(), uint8_t(mover), 0});
+        }
+        ++plies;
+        if (mover < 0 || mover >= n)
+            return;
+        if (move.is_wall) {
+            walls.push_back({move.x, move.y, move.is_vertical});
+            players[mover].walls--;
+        } else {
+            players[mover].x = move.x;
+            players[mover].y = move.y;
+        }
+    }
+
+    int m = 0, n = 0;
+    vector<Player> players;
+    vector<Wall> walls;
+    vector<Sample> samples;
+    /** Score of every player at the end of the game, in `BOOK_SCORE_UNIT`ths */
+    int points[MAX_PLAYERS]{};
+
+private:
+    int max_plies, plies = 0;
+};
+
+/** Feeds the ticks of a server match log to a GameReplay */
+struct LogReplay {
+    GameReplay &replay;
+    int distance[MAX_PLAYERS]{};
+    int num_players = 0;
+    int race_winner = -1;
+
+    void on_init(const InitView &init) {
+        replay.m = init.board_size;
+        num_players = init.num_players;
+    }
+
+    void on_tick(const TickView &tick) {
+        if (tick.action == ACTION_START) {
+            vector<Player> players(num_players);
+            for (int i = 0; i < num_players && i < tick.num_pawns; ++i)
+                players[i] = {tick.pawn_x[i], tick.pawn_y[i], tick.owned_walls[i]};
+            replay.start(replay.m, players);
+        } else if (tick.action == ACTION_MOVE || tick.action == ACTION_PLACE) {
+            int mover = tick.current_player;
+            // An offline bot's move is the server's random step, even on ticks that log no new error
+            bool valid = mover >= 0 && mover < MAX_PLAYERS && !tick.bots[mover].has_error &&
+                         !tick.bots[mover].offline;
+            replay.play(mover, {tick.action == ACTION_PLACE, tick.action_x, tick.action_y, tick.action_vertical != 0}, valid);
+        }
+        for (int i = 0; i < num_players; ++i)
+            distance[i] = tick.bots[i].distance;
+        race_winner = tick.race_winner;
+    }
+
+    /** Scores like the server: the winner of a decided race, or else the players closest to the goal share the point */
+    void finish() {
+        if (race_winner >= 0) {
+            for (int i = 0; i < num_players; ++i)
+                replay.points[i] = i == race_winner ? BOOK_SCORE_UNIT : 0;
+            return;
+        }
+        int best = INT_MAX, winners = 0;
+        for (int i = 0; i < num_players; ++i) {
+            if (distance[i] >= 0 && distance[i] < best) {
+                best = distance[i];
+                winners = 0;
+            }
+            winners += distance[i] == best;
+        }
+        for (int i = 0; i < num_players; ++i)
+            replay.points[i] = distance[i] == best ? BOOK_SCORE_UNIT / winners : 0;
+    }
+};
+
+void read_game_record(const string &path, GameReplay &replay) {
+    ifstream in(path);
+    int m, n, walls, starting_player;
+    if (!(in >> m >> n >> walls >> starting_player) || n < 2 || n > MAX_PLAYERS)
+        throw runtime_error("bad header");
+    vector<Player> players(n);
+    for (Player &player: players) {
+        in >> player.x >> player.y;
+        player.walls = walls;
+    }
+    replay.start(m, players);
+    string line;
+    getline(in, line);
+    int mover = starting_player;
+    while (getline(in, line)) {
+        istringstream words(line);
+        string first;
+        if (!(words >> first))
+            continue;
+        if (first == "result") {
+            int winner;
+            words >> winner;
+            for (int i = 0; i < n; ++i)
+                replay.points[i] = winner == -1 ? BOOK_SCORE_UNIT / n : winner == i ? BOOK_SCORE_UNIT : 0;
+            return;
+        }
+        vector<int> values{stoi(first)};
+        for (int value; words >> value;)
+            values.push_back(value);
+        if (values.size() == 2)
+            replay.play(mover, {false, values[0], values[1], false});
+        else if (values.size() == 3)
+            replay.play(mover, {true, values[0], values[1], values[2] != 0});
+        else
+            throw runtime_error("bad move: " + line);
+        mover = (mover + 1) % n;
+    }
+    throw runtime_error("missing result");
+}
+
+int main(int argc, char **argv) {
+    vector<string> args(argv + 1, argv + argc), roots;
+    unsigned threads = thread::hardware_concurrency();
+    int max_plies = 20;
+    for (size_t i = 1; i < args.size(); ++i) {
+        if (args[i] == "-j" && i + 1 < args.size())
+            threads = stoi(args[++i]);
+        else if (args[i] == "--plies" && i + 1 < args.size())
+            max_plies = stoi(args[++i]);
+        else
+            roots.push_back(args[i]);
+    }
+    if (args.empty() || roots.empty()) {
+        cerr << "usage: " << argv[0] << " <book> <match.log, game record or directory>... [-j threads] [--plies 20]" << endl;
+        return 2;
+    }
+
+    vector<string> paths = find_match_logs(roots, {"match.log", ".game"});
+    vector<vector<Sample>> samples(paths.size());
+    vector<pair<int, int>> shapes(paths.size());
+    atomic<size_t> failed{0};
+    parallel_for(paths.size(), threads, [&](size_t i) {
+        GameReplay replay(max_plies);
+        try {
+            if (filesystem::path(paths[i]).extension() == ".game") {
+                read_game_record(paths[i], replay);
+            } else {
+                MappedFile file(paths[i]);
+                LogReplay log{replay};
+                scan_match_log(file.data(), file.size(), log);
+                log.finish();
+            }
+        } catch (const exception &error) {
+            cerr << "skipping " << paths[i] << ": " << error.what() << endl;
+            ++failed;
+            return;
+        }
+        for (Sample &sample: replay.samples)
+            sample.points = replay.points[sample.mover];
+        samples[i] = move(replay.samples);
+        shapes[i] = {replay.m, replay.n};
+    });
+
+    // Merge, then aggregate the games of every (position, move) pair
+    vector<Sample> all;
+    set<pair<int, int>> board_shapes;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (samples[i].empty())
+            continue;
+        all.insert(all.end(), samples[i].begin(), samples[i].end());
+        board_shapes.insert(shapes[i]);
+        vector<Sample>().swap(samples[i]);
+    }
+    sort(all.begin(), all.end(), [](const Sample &a, const Sample &b) {
+        return a.key != b.key ? a.key < b.key : a.move < b.move;
+    });
+    vector<BookEntry> entries;
+    for (size_t i = 0, j; i < all.size(); i = j) {
+        uint64_t games = 0, points = 0;
+        for (j = i; j < all.size() && all[j].key == all[i].key && all[j].move == all[i].move; ++j) {
+            ++games;
+            points += all[j].points;
+        }
+        if (games > UINT16_MAX) {
+            points = points * UINT16_MAX / games;
+            games = UINT16_MAX;
+        }
+        entries.push_back({all[i].key, all[i].move, uint16_t(games), uint32_t(points)});
+    }
+
+    BookHeader header{};
+    memcpy(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC));
+    if (board_shapes.size() == 1) {
+        header.board_size = board_shapes.begin()->first;
+        header.num_players = board_shapes.begin()->second;
+    }
+    header.num_entries = entries.size();
+    FILE *out = fopen(args[0].c_str(), "wb");
+    if (!out || fwrite(&header, sizeof(header), 1, out) != 1 ||
+        fwrite(entries.data(), sizeof(BookEntry), entries.size(), out) != entries.size()) {
+        cerr << "cannot write " << args[0] << endl;
+        return 1;
+    }
+    fclose(out);
+    cerr << "book of " << entries.size() << " moves from " << all.size() << " plies of " << paths.size() - failed
+         << " games" << endl;
+    return 0;
+}
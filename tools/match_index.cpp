@@ -0,0 +1,423 @@
+/**
+ * Builds a columnar index over archives of `match.log` files and answers queries on it.
+ *
+ *     g++ -O2 -std=c++17 -pthread -o match_index tools/match_index.cpp
+ *     ./match_index build matches.idx logs/ [-j threads]
+ *     ./match_index query matches.idx timeouts|think-time|game-length|wall-gains [min gain]|summary
+ *
+ * Building streams every log through the reader in match_log_reader.h on all cores. The index is a
+ * header followed by a file table, a string table and one array per tick column, so queries only
+ * memory-map it and scan the columns they need.
+ */
+#include "match_log_reader.h"
+
+using namespace std;
+
+enum ErrorKind : uint8_t {
+    ERROR_NONE = 0,
+    ERROR_TIMEOUT = 1,
+    ERROR_INVALID_STEP = 2,
+    ERROR_OFFLINE = 3,
+    ERROR_CRASH = 4,
+};
+
+const char *ERROR_NAMES[] = {"none", "timeout", "invalid step", "offline", "crash"};
+
+/** Maps the error messages of src/quoridor.ts and src/BotWrapper.ts to a few categories */
+ErrorKind classify_error(string_view message) {
+    if (message.find("response time limit exceeded") != string_view::npos)
+        return ERROR_TIMEOUT;
+    if (message.find("Invalid input!") != string_view::npos)
+        return ERROR_INVALID_STEP;
+    if (message.find("error state") != string_view::npos)
+        return ERROR_OFFLINE;
+    return ERROR_CRASH;
+}
+
+enum Column {
+    COLUMN_FILE,            // uint32_t, index into the file table
+    COLUMN_TICK,            // uint16_t, position of the tick inside its match, 0 is the start tick
+    COLUMN_PLAYER,          // int8_t, current player
+    COLUMN_ACTION,          // uint8_t, ActionKind
+    COLUMN_ACTION_X,        // int8_t
+    COLUMN_ACTION_Y,        // int8_t
+    COLUMN_ACTION_VERTICAL, // int8_t
+    COLUMN_DISTANCE,        // int16_t[MAX_PLAYERS], distance from goal after the action, -1 if out
+    COLUMN_THINK_MS,        // int32_t, answer time of the current player, -1 if it did not answer
+    COLUMN_ERROR,           // uint8_t, ErrorKind of the current player
+    COLUMN_WALLS,           // uint16_t, walls on the board after the action
+    NUM_COLUMNS,
+};
+
+const size_t COLUMN_WIDTH[NUM_COLUMNS] = {4, 2, 1, 1, 1, 1, 1, 2 * MAX_PLAYERS, 4, 1, 2};
+
+const char INDEX_MAGIC[8] = {'Q', 'M', 'I', 'D', 'X', 0, 0, 1};
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t num_files;
+    uint32_t strings_size;
+    uint64_t num_ticks;
+    uint64_t files_offset;
+    uint64_t strings_offset;
+    uint64_t column_offset[NUM_COLUMNS];
+};
+
+/** One row of the file table, strings are offsets into the string table */
+struct FileRecord {
+    uint64_t first_tick;
+    uint32_t num_ticks;
+    uint32_t path;
+    uint32_t map;
+    uint32_t bot_id[MAX_PLAYERS];
+    uint32_t bot_name[MAX_PLAYERS];
+    uint8_t board_size;
+    uint8_t num_players;
+    /** Index of the player with the smallest final distance or of the decided race's winner, -1 on a tie */
+    int8_t winner;
+    uint8_t padding;
+};
+
+static_assert(sizeof(FileRecord) == 56, "FileRecord is written to disk as is");
+
+/** Columns and metadata of a single log, produced by a worker thread */
+struct FileIndex {
+    string path, map;
+    string bot_id[MAX_PLAYERS], bot_name[MAX_PLAYERS];
+    int board_size = 0, num_players = 0, winner = -1;
+    vector<uint8_t> columns[NUM_COLUMNS];
+    size_t num_ticks = 0;
+
+    template<typename T>
+    void push(Column column, T value) {
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+        columns[column].insert(columns[column].end(), bytes, bytes + sizeof(T));
+    }
+
+    void on_init(const InitView &init) {
+        board_size = init.board_size;
+        num_players = init.num_players;
+        for (int i = 0; i < init.num_players; ++i) {
+            bot_id[i] = string(init.players[i].id);
+            bot_name[i] = string(init.players[i].name);
+        }
+    }
+
+    void on_tick(const TickView &tick) {
+        if (num_ticks > UINT16_MAX)
+            throw runtime_error("too many ticks");
+        if (num_ticks == 0) {
+            // The start tick has the initial pawns and walls, together with the board size they identify the map
+            map = ::to_string(board_size) + "x" + ::to_string(board_size) + " walls=" +
+                  (tick.num_owned ? ::to_string(tick.owned_walls[0]) : "0");
+        } else if (num_ticks == 1) {
+            map += " start=" + ::to_string(tick.current_player);
+        }
+        const BotView &current = tick.bots[tick.current_player >= 0 && tick.current_player < MAX_PLAYERS ? tick.current_player : 0];
+        push(COLUMN_TICK, uint16_t(num_ticks));
+        push(COLUMN_PLAYER, int8_t(tick.current_player));
+        push(COLUMN_ACTION, uint8_t(tick.action));
+        push(COLUMN_ACTION_X, int8_t(tick.action_x));
+        push(COLUMN_ACTION_Y, int8_t(tick.action_y));
+        push(COLUMN_ACTION_VERTICAL, int8_t(tick.action_vertical));
+        for (int i = 0; i < MAX_PLAYERS; ++i)
+            push(COLUMN_DISTANCE, int16_t(i < num_players ? tick.bots[i].distance : -1));
+        push(COLUMN_THINK_MS, int32_t(tick.action == ACTION_START ? -1 : current.think_ms()));
+        push(COLUMN_ERROR, uint8_t(current.has_error ? classify_error(current.error) : ERROR_NONE));
+        push(COLUMN_WALLS, uint16_t(tick.num_walls));
+        ++num_ticks;
+
+        if (tick.race_winner >= 0) {
+            // Stopped early, the winner may not be closer to its goal yet
+            winner = tick.race_winner;
+            return;
+        }
+        int best = INT_MAX;
+        winner = -1;
+        for (int i = 0; i < num_players; ++i) {
+            int distance = tick.bots[i].distance;
+            if (distance < 0)
+                continue;
+            if (distance < best) {
+                best = distance;
+                winner = i;
+            } else if (distance == best) {
+                winner = -1;
+            }
+        }
+    }
+};
+
+class StringTable {
+public:
+    uint32_t add(const string &value) {
+        auto it = offsets.find(value);
+        if (it != offsets.end())
+            return it->second;
+        uint32_t offset = data.size();
+        data.insert(data.end(), value.begin(), value.end());
+        data.push_back('\0');
+        offsets.emplace(value, offset);
+        return offset;
+    }
+
+    vector<char> data;
+
+private:
+    unordered_map<string, uint32_t> offsets;
+};
+
+void write_padded(FILE *out, const void *data, size_t size, uint64_t &offset) {
+    if (size && fwrite(data, 1, size, out) != size)
+        throw runtime_error("write failed");
+    offset += size;
+    static const char zeros[8] = {};
+    size_t padding = (8 - offset % 8) % 8;
+    if (padding && fwrite(zeros, 1, padding, out) != padding)
+        throw runtime_error("write failed");
+    offset += padding;
+}
+
+int build(const string &index_path, const vector<string> &roots, unsigned threads) {
+    vector<string> paths = find_match_logs(roots);
+    vector<FileIndex> results(paths.size());
+    vector<string> errors(paths.size());
+    parallel_for(paths.size(), threads, [&](size_t i) {
+        try {
+            MappedFile file(paths[i]);
+            results[i].path = paths[i];
+            scan_match_log(file.data(), file.size(), results[i]);
+        } catch (const exception &error) {
+            errors[i] = error.what();
+        }
+    });
+
+    IndexHeader header{};
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    StringTable strings;
+    vector<FileRecord> files;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!errors[i].empty() || results[i].num_ticks == 0) {
+            cerr << "skipping " << paths[i] << ": " << (errors[i].empty() ? "no ticks" : errors[i]) << endl;
+            continue;
+        }
+        const FileIndex &result = results[i];
+        FileRecord record{};
+        record.first_tick = header.num_ticks;
+        record.num_ticks = result.num_ticks;
+        record.path = strings.add(result.path);
+        record.map = strings.add(result.map);
+        for (int p = 0; p < MAX_PLAYERS; ++p) {
+            record.bot_id[p] = strings.add(result.bot_id[p]);
+            record.bot_name[p] = strings.add(result.bot_name[p]);
+        }
+        record.board_size = result.board_size;
+        record.num_players = result.num_players;
+        record.winner = result.winner;
+        files.push_back(record);
+        header.num_ticks += result.num_ticks;
+    }
+    header.num_files = files.size();
+    header.strings_size = strings.data.size();
+
+    FILE *out = fopen(index_path.c_str(), "wb");
+    if (!out)
+        throw runtime_error("cannot create " + index_path);
+    uint64_t offset = 0;
+    write_padded(out, &header, sizeof(header), offset);
+    header.files_offset = offset;
+    write_padded(out, files.data(), files.size() * sizeof(FileRecord), offset);
+    header.strings_offset = offset;
+    write_padded(out, strings.data.data(), strings.data.size(), offset);
+    for (int column = 0; column < NUM_COLUMNS; ++column) {
+        header.column_offset[column] = offset;
+        size_t file_index = 0;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            if (!errors[i].empty() || results[i].num_ticks == 0)
+                continue;
+            if (column == COLUMN_FILE) {
+                vector<uint32_t> ids(results[i].num_ticks, file_index);
+                results[i].columns[column].assign(reinterpret_cast<uint8_t *>(ids.data()),
+                                                  reinterpret_cast<uint8_t *>(ids.data() + ids.size()));
+            }
+            const vector<uint8_t> &data = results[i].columns[column];
+            if (!data.empty() && fwrite(data.data(), 1, data.size(), out) != data.size())
+                throw runtime_error("write failed");
+            offset += data.size();
+            vector<uint8_t>().swap(results[i].columns[column]);
+            ++file_index;
+        }
+        write_padded(out, nullptr, 0, offset);
+    }
+    // The offsets are only known now, rewrite the header
+    if (fseek(out, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, out) != 1)
+        throw runtime_error("write failed");
+    fclose(out);
+    cerr << "indexed " << header.num_files << " matches, " << header.num_ticks << " ticks" << endl;
+    return 0;
+}
+
+/** Read-only view of an index file */
+class MatchIndex {
+public:
+    explicit MatchIndex(const string &path) : file(path) {
+        if (file.size() < sizeof(IndexHeader) || memcmp(file.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+            throw runtime_error(path + " is not a match index");
+        header = reinterpret_cast<const IndexHeader *>(file.data());
+        if (header->column_offset[NUM_COLUMNS - 1] + header->num_ticks * COLUMN_WIDTH[NUM_COLUMNS - 1] > file.size())
+            throw runtime_error(path + " is truncated");
+    }
+
+    size_t num_files() const { return header->num_files; }
+
+    size_t num_ticks() const { return header->num_ticks; }
+
+    const FileRecord &match(size_t i) const {
+        return reinterpret_cast<const FileRecord *>(file.data() + header->files_offset)[i];
+    }
+
+    const char *str(uint32_t offset) const {
+        return reinterpret_cast<const char *>(file.data() + header->strings_offset + offset);
+    }
+
+    template<typename T>
+    const T *column(Column column) const {
+        return reinterpret_cast<const T *>(file.data() + header->column_offset[column]);
+    }
+
+private:
+    MappedFile file;
+    const IndexHeader *header;
+};
+
+void query_timeouts(const MatchIndex &index) {
+    auto file = index.column<uint32_t>(COLUMN_FILE);
+    auto player = index.column<int8_t>(COLUMN_PLAYER);
+    auto action = index.column<uint8_t>(COLUMN_ACTION);
+    auto error = index.column<uint8_t>(COLUMN_ERROR);
+    map<string, array<uint64_t, 2>> per_bot; // timeouts, answered ticks
+    for (size_t t = 0; t < index.num_ticks(); ++t) {
+        if (action[t] == ACTION_START || action[t] == ACTION_STUCK || player[t] < 0)
+            continue;
+        const FileRecord &match = index.match(file[t]);
+        auto &counts = per_bot[string(index.str(match.bot_id[player[t]])) + " (" + index.str(match.bot_name[player[t]]) + ")"];
+        counts[0] += error[t] == ERROR_TIMEOUT;
+        counts[1]++;
+    }
+    vector<pair<string, array<uint64_t, 2>>> rows(per_bot.begin(), per_bot.end());
+    sort(rows.begin(), rows.end(), [](const auto &a, const auto &b) { return a.second[0] > b.second[0]; });
+    for (const auto &[bot, counts]: rows)
+        printf("%-40s %8lu timeouts in %8lu ticks\n", bot.c_str(), (unsigned long) counts[0], (unsigned long) counts[1]);
+}
+
+void query_think_time(const MatchIndex &index) {
+    auto file = index.column<uint32_t>(COLUMN_FILE);
+    auto player = index.column<int8_t>(COLUMN_PLAYER);
+    auto think_ms = index.column<int32_t>(COLUMN_THINK_MS);
+    map<string, array<int64_t, 3>> per_bot; // sum, count, max
+    for (size_t t = 0; t < index.num_ticks(); ++t) {
+        if (think_ms[t] < 0 || player[t] < 0)
+            continue;
+        auto &stats = per_bot[index.str(index.match(file[t]).bot_id[player[t]])];
+        stats[0] += think_ms[t];
+        stats[1]++;
+        stats[2] = max<int64_t>(stats[2], think_ms[t]);
+    }
+    for (const auto &[bot, stats]: per_bot)
+        printf("%-30s avg %8.1f ms  max %6ld ms  over %8ld answers\n", bot.c_str(), (double) stats[0] / stats[1], (long) stats[2], (long) stats[1]);
+}
+
+void query_game_length(const MatchIndex &index) {
+    map<string, array<uint64_t, 3>> per_map; // matches, ticks, decided matches
+    for (size_t i = 0; i < index.num_files(); ++i) {
+        const FileRecord &match = index.match(i);
+        auto &stats = per_map[index.str(match.map)];
+        stats[0]++;
+        stats[1] += match.num_ticks - 1; // without the start tick
+        stats[2] += match.winner >= 0;
+    }
+    for (const auto &[map_key, stats]: per_map)
+        printf("%-30s %6lu matches  avg %6.1f ticks  %6lu decided\n", map_key.c_str(), (unsigned long) stats[0],
+               (double) stats[1] / stats[0], (unsigned long) stats[2]);
+}
+
+void query_wall_gains(const MatchIndex &index, int min_gain) {
+    auto file = index.column<uint32_t>(COLUMN_FILE);
+    auto tick = index.column<uint16_t>(COLUMN_TICK);
+    auto player = index.column<int8_t>(COLUMN_PLAYER);
+    auto action = index.column<uint8_t>(COLUMN_ACTION);
+    auto x = index.column<int8_t>(COLUMN_ACTION_X);
+    auto y = index.column<int8_t>(COLUMN_ACTION_Y);
+    auto vertical = index.column<int8_t>(COLUMN_ACTION_VERTICAL);
+    auto distance = index.column<int16_t>(COLUMN_DISTANCE);
+    size_t found = 0;
+    for (size_t t = 1; t < index.num_ticks(); ++t) {
+        if (action[t] != ACTION_PLACE || tick[t] == 0)
+            continue;
+        const FileRecord &match = index.match(file[t]);
+        for (int p = 0; p < match.num_players; ++p) {
+            int before = distance[(t - 1) * MAX_PLAYERS + p], after = distance[t * MAX_PLAYERS + p];
+            if (p == player[t] || before < 0 || after < 0 || after - before < min_gain)
+                continue;
+            printf("%s tick %d: player %d wall %d %d %d, player %d distance %d -> %d\n", index.str(match.path), tick[t],
+                   player[t], x[t], y[t], vertical[t], p, before, after);
+            ++found;
+        }
+    }
+    printf("%lu positions\n", (unsigned long) found);
+}
+
+void query_summary(const MatchIndex &index) {
+    auto error = index.column<uint8_t>(COLUMN_ERROR);
+    uint64_t errors[5] = {};
+    for (size_t t = 0; t < index.num_ticks(); ++t)
+        errors[min<int>(error[t], 4)]++;
+    printf("%lu matches, %lu ticks\n", (unsigned long) index.num_files(), (unsigned long) index.num_ticks());
+    for (int kind = ERROR_TIMEOUT; kind <= ERROR_CRASH; ++kind)
+        printf("%-14s %lu\n", ERROR_NAMES[kind], (unsigned long) errors[kind]);
+}
+
+int query(const string &index_path, const string &name, const vector<string> &args) {
+    auto start = chrono::steady_clock::now();
+    MatchIndex index(index_path);
+    if (name == "timeouts")
+        query_timeouts(index);
+    else if (name == "think-time")
+        query_think_time(index);
+    else if (name == "game-length")
+        query_game_length(index);
+    else if (name == "wall-gains")
+        query_wall_gains(index, args.empty() ? 4 : stoi(args[0]));
+    else if (name == "summary")
+        query_summary(index);
+    else
+        throw runtime_error("unknown query " + name);
+    auto elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cerr << "query took " << elapsed << " ms" << endl;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    vector<string> args(argv + 1, argv + argc);
+    try {
+        if (args.size() >= 3 && args[0] == "build") {
+            unsigned threads = thread::hardware_concurrency();
+            vector<string> roots;
+            for (size_t i = 2; i < args.size(); ++i) {
+                if (args[i] == "-j" && i + 1 < args.size())
+                    threads = stoi(args[++i]);
+                else
+                    roots.push_back(args[i]);
+            }
+            return build(args[1], roots, threads);
+        }
+        if (args.size() >= 3 && args[0] == "query")
+            return query(args[1], args[2], vector<string>(args.begin() + 3, args.end()));
+    } catch (const exception &error) {
+        cerr << error.what() << endl;
+        return 1;
+    }
+    cerr << "usage: " << argv[0] << " build <index> <match.log or directory>... [-j threads]" << endl
+         << "       " << argv[0] << " query <index> timeouts|think-time|game-length|wall-gains [min gain]|summary" << endl;
+    return 2;
+}
@@ -0,0 +1,394 @@
+#pragma once
+
+#include <bits/stdc++.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * Streaming reader for the `match.log` files written by the server (see src/protobuf/match_log.proto).
+ * Nothing is decoded into message objects: the file is memory-mapped, walked with a cursor and every
+ * tick is reported as a small fixed-size view whose strings point into the mapping.
+ */
+
+constexpr int MAX_PLAYERS = 4;
+
+/** Read-only memory mapping of a whole file */
+class MappedFile {
+public:
+    explicit MappedFile(const string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw runtime_error("cannot open " + path);
+        struct stat st{};
+        if (fstat(fd, &st) < 0) {
+            close(fd);
+            throw runtime_error("cannot stat " + path);
+        }
+        length = st.st_size;
+        if (length > 0) {
+            void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                close(fd);
+                throw runtime_error("cannot map " + path);
+            }
+            bytes = static_cast<const uint8_t *>(mapped);
+        }
+        close(fd);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile() {
+        if (bytes)
+            munmap(const_cast<uint8_t *>(bytes), length);
+    }
+
+    const uint8_t *data() const { return bytes; }
+
+    size_t size() const { return length; }
+
+private:
+    const uint8_t *bytes = nullptr;
+    size_t length = 0;
+};
+
+/** Cursor over one encoded protobuf message */
+struct ProtoReader {
+    const uint8_t *pos, *end;
+
+    bool done() const { return pos >= end; }
+
+    uint64_t varint() {
+        uint64_t result = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= end)
+                throw runtime_error("truncated varint");
+            uint8_t byte = *pos++;
+            result |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return result;
+        }
+        throw runtime_error("malformed varint");
+    }
+
+    /** Negative int32 values are sign extended to ten bytes on the wire, truncating gives them back */
+    int32_t int32() { return (int32_t) (uint32_t) varint(); }
+
+    /** Reads the next field key, returns false at the end of the message */
+    bool next(int &field, int &wire_type) {
+        if (done())
+            return false;
+        uint64_t key = varint();
+        field = (int) (key >> 3);
+        wire_type = (int) (key & 7);
+        return true;
+    }
+
+    ProtoReader message() {
+        uint64_t length = varint();
+        if (length > uint64_t(end - pos))
+            throw runtime_error("truncated message");
+        ProtoReader sub{pos, pos + length};
+        pos += length;
+        return sub;
+    }
+
+    string_view bytes() {
+        ProtoReader sub = message();
+        return {reinterpret_cast<const char *>(sub.pos), size_t(sub.end - sub.pos)};
+    }
+
+    void skip(int wire_type) {
+        switch (wire_type) {
+            case 0:
+                varint();
+                return;
+            case 1:
+                advance(8);
+                return;
+            case 2:
+                message();
+                return;
+            case 5:
+                advance(4);
+                return;
+            default:
+                throw runtime_error("unsupported wire type " + to_string(wire_type));
+        }
+    }
+
+private:
+    void advance(size_t count) {
+        if (count > size_t(end - pos))
+            throw runtime_error("truncated field");
+        pos += count;
+    }
+};
+
+struct PlayerView {
+    string_view id, name;
+};
+
+struct InitView {
+    int board_size = 0;
+    int num_of_walls = 0;
+    int num_players = 0;
+    PlayerView players[MAX_PLAYERS];
+};
+
+enum ActionKind : uint8_t {
+    ACTION_NONE = 0,
+    ACTION_START = 1,
+    ACTION_MOVE = 2,
+    ACTION_PLACE = 3,
+    ACTION_STUCK = 4,
+};
+
+struct BotView {
+    bool present = false;
+    bool offline = false;
+    int distance = 0;
+    /** Timestamp of the last message the server sent to the bot and of the first answer, 0 if there was none */
+    uint64_t last_received = 0, first_sent = 0;
+    string_view error;
+    bool has_error = false;
+
+    /** Milliseconds between the last message to the bot and its first answer, -1 if it did not answer */
+    int64_t think_ms() const {
+        if (!last_received || !first_sent || first_sent < last_received)
+            return -1;
+        return int64_t(first_sent - last_received);
+    }
+};
+
+struct TickView {
+    int current_player = 0;
+    int num_pawns = 0;
+    int pawn_x[MAX_PLAYERS]{}, pawn_y[MAX_PLAYERS]{};
+    int num_owned = 0;
+    int owned_walls[MAX_PLAYERS]{};
+    int num_walls = 0;
+    ActionKind action = ACTION_NONE;
+    int action_x = 0, action_y = 0, action_vertical = 0;
+    BotView bots[MAX_PLAYERS];
+    /** Winner of a match the server stopped because the race was decided, -1 on every other tick */
+    int race_winner = -1;
+};
+
+namespace match_log_detail {
+    inline void read_xy(ProtoReader message, int &x, int &y, int *vertical = nullptr) {
+        int field, wire_type;
+        while (message.next(field, wire_type)) {
+            if (field == 1 && wire_type == 0)
+                x = message.int32();
+            else if (field == 2 && wire_type == 0)
+                y = message.int32();
+            else if (field == 3 && wire_type == 0 && vertical)
+                *vertical = message.int32();
+            else
+                message.skip(wire_type);
+        }
+    }
+
+    inline uint64_t read_timestamp(ProtoReader message) {
+        int field, wire_type;
+        uint64_t timestamp = 0;
+        while (message.next(field, wire_type)) {
+            if (field == 2 && wire_type == 0)
+                timestamp = message.varint();
+            else
+                message.skip(wire_type);
+        }
+        return timestamp;
+    }
+
+    inline void read_bot(ProtoReader message, TickView &tick) {
+        BotView bot;
+        bot.present = true;
+        int index = 0, field, wire_type;
+        while (message.next(field, wire_type)) {
+            if (field == 2 && wire_type == 0) {
+                index = message.int32();
+            } else if (field == 3 && wire_type == 2) {
+                bot.last_received = read_timestamp(message.message());
+            } else if (field == 4 && wire_type == 2) {
+                uint64_t timestamp = read_timestamp(message.message());
+                if (!bot.first_sent)
+                    bot.first_sent = timestamp;
+            } else if (field == 5 && wire_type == 2) {
+                bot.error = message.bytes();
+                bot.has_error = true;
+            } else if (field == 7 && wire_type == 0) {
+                bot.distance = message.int32();
+            } else if (field == 8 && wire_type == 0) {
+                bot.offline = message.varint() != 0;
+            } else {
+                message.skip(wire_type);
+            }
+        }
+        if (index < 0 || index >= MAX_PLAYERS)
+            throw runtime_error("bot index out of range");
+        tick.bots[index] = bot;
+    }
+
+    inline void read_tick(ProtoReader message, TickView &tick) {
+        tick = TickView();
+        int field, wire_type;
+        while (message.next(field, wire_type)) {
+            switch (field) {
+                case 1:
+                    tick.current_player = message.int32();
+                    break;
+                case 2:
+                    if (tick.num_pawns == MAX_PLAYERS)
+                        throw runtime_error("too many pawns");
+                    read_xy(message.message(), tick.pawn_x[tick.num_pawns], tick.pawn_y[tick.num_pawns]);
+                    ++tick.num_pawns;
+                    break;
+                case 3:
+                    message.skip(wire_type);
+                    ++tick.num_walls;
+                    break;
+                case 4:
+                    // proto3 packs repeated scalars, but unpacked encoding is valid as well
+                    if (wire_type == 2) {
+                        ProtoReader packed = message.message();
+                        while (!packed.done() && tick.num_owned < MAX_PLAYERS)
+                            tick.owned_walls[tick.num_owned++] = packed.int32();
+                    } else if (tick.num_owned < MAX_PLAYERS) {
+                        tick.owned_walls[tick.num_owned++] = message.int32();
+                    } else {
+                        message.skip(wire_type);
+                    }
+                    break;
+                case 5:
+                    message.skip(wire_type);
+                    tick.action = ACTION_START;
+                    break;
+                case 6:
+                    tick.action = ACTION_MOVE;
+                    read_xy(message.message(), tick.action_x, tick.action_y);
+                    break;
+                case 7:
+                    tick.action = ACTION_PLACE;
+                    read_xy(message.message(), tick.action_x, tick.action_y, &tick.action_vertical);
+                    break;
+                case 8:
+                    message.skip(wire_type);
+                    tick.action = ACTION_STUCK;
+                    break;
+                case 9:
+                    read_bot(message.message(), tick);
+                    break;
+                case 10:
+                    tick.race_winner = message.int32();
+                    break;
+                default:
+                    message.skip(wire_type);
+            }
+        }
+    }
+
+    inline void read_init(ProtoReader message, InitView &init) {
+        init = InitView();
+        int field, wire_type;
+        while (message.next(field, wire_type)) {
+            if (field == 1 && wire_type == 2) {
+                ProtoReader player = message.message();
+                PlayerView view;
+                int index = 0, player_field, player_wire_type;
+                while (player.next(player_field, player_wire_type)) {
+                    if (player_field == 1 && player_wire_type == 2)
+                        view.id = player.bytes();
+                    else if (player_field == 2 && player_wire_type == 0)
+                        index = player.int32();
+                    else if (player_field == 3 && player_wire_type == 2)
+                        view.name = player.bytes();
+                    else
+                        player.skip(player_wire_type);
+                }
+                if (index < 0 || index >= MAX_PLAYERS)
+                    throw runtime_error("player index out of range");
+                init.players[index] = view;
+                init.num_players = max(init.num_players, index + 1);
+            } else if (field == 2 && wire_type == 0) {
+                init.board_size = message.int32();
+            } else if (field == 3 && wire_type == 0) {
+                init.num_of_walls = message.int32();
+            } else {
+                message.skip(wire_type);
+            }
+        }
+    }
+}
+
+/**
+ * Walks an encoded `Match`, calling `on_init(const InitView &)` and `on_tick(const TickView &)` on the handler.
+ * The server writes `init` before the ticks, the views are only valid during the callback.
+ */
+template<typename Handler>
+void scan_match_log(const uint8_t *data, size_t size, Handler &handler) {
+    ProtoReader match{data, data + size};
+    InitView init;
+    TickView tick;
+    int field, wire_type;
+    while (match.next(field, wire_type)) {
+        if (field == 1 && wire_type == 2) {
+            match_log_detail::read_init(match.message(), init);
+            handler.on_init(init);
+        } else if (field == 2 && wire_type == 2) {
+            match_log_detail::read_tick(match.message(), tick);
+            handler.on_tick(tick);
+        } else {
+            match.skip(wire_type);
+        }
+    }
+}
+
+/**
+ * Collects the files below the given directories that match one of the patterns, and the given files, sorted.
+ * A pattern starting with a dot is an extension, any other one a whole file name. Not every `.log` is a match
+ * log: the tournament's match directories hold the server's text output in server.log.
+ */
+inline vector<string> find_match_logs(const vector<string> &roots, const vector<string> &patterns = {"match.log"}) {
+    auto matches = [&](const filesystem::path &path) {
+        return any_of(patterns.begin(), patterns.end(), [&](const string &pattern) {
+            return pattern[0] == '.' ? path.extension() == pattern : path.filename() == pattern;
+        });
+    };
+    vector<string> paths;
+    for (const string &root: roots) {
+        if (filesystem::is_directory(root)) {
+            for (const auto &entry: filesystem::recursive_directory_iterator(root)) {
+                if (entry.is_regular_file() && matches(entry.path()))
+                    paths.push_back(entry.path().string());
+            }
+        } else {
+            paths.push_back(root);
+        }
+    }
+    sort(paths.begin(), paths.end());
+    return paths;
+}
+
+/** Runs `work(index)` for every index in [0, count) on `threads` worker threads */
+template<typename Work>
+void parallel_for(size_t count, unsigned threads, Work work) {
+    atomic<size_t> next{0};
+    vector<thread> workers;
+    threads = max(1u, min<unsigned>(threads, (unsigned) max<size_t>(count, 1)));
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back([&]() {
+            for (size_t index = next++; index < count; index = next++)
+                work(index);
+        });
+    }
+    for (thread &worker: workers)
+        worker.join();
+}